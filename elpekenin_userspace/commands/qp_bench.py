@@ -0,0 +1,206 @@
+"""Subcommand to measure asset lookups on the host."""
+
+from __future__ import annotations
+
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import TYPE_CHECKING
+
+from elpekenin_userspace.commands import BaseCommand
+from elpekenin_userspace.commands.qp_resources import perfect_hash, slot_hash
+from elpekenin_userspace.result import Err, Ok
+
+if TYPE_CHECKING:
+    from argparse import ArgumentParser, Namespace
+
+    from elpekenin_userspace.result import Result
+
+# same length as a typical asset name, eg: "fira_code_12"
+NAME_LENGTH = 12
+
+# NOTE: hash and slot lookup must match `qp_asset_hash` and `find_slot` in `users/elpekenin/src/qp/assets.c`
+C_SOURCE = """\
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {{
+    uint32_t    hash;
+    const char *name;
+}} slot_t;
+
+static const char *names[] = {{{names}}};
+static const uint16_t seeds[] = {{{seeds}}};
+static const slot_t slots[] = {{{slots}}};
+
+#define N_NAMES (sizeof(names) / sizeof(names[0]))
+#define N_BUCKETS (sizeof(seeds) / sizeof(seeds[0]))
+#define N_SLOTS (sizeof(slots) / sizeof(slots[0]))
+
+static uint32_t qp_asset_hash(uint32_t seed, const char *name) {{
+    uint32_t hash = 2166136261u ^ seed;
+
+    for (; *name != '\\0'; ++name) {{
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }}
+
+    return hash;
+}}
+
+static bool find_slot(const char *name, size_t *slot) {{
+    const uint32_t bucket = qp_asset_hash(0, name) % N_BUCKETS;
+    const uint32_t hash   = qp_asset_hash(seeds[bucket], name);
+
+    *slot = hash % N_SLOTS;
+
+    return slots[*slot].name != NULL && slots[*slot].hash == hash;
+}}
+
+// what lookups did before the perfect hash
+static bool find_linear(const char *name, size_t *slot) {{
+    for (size_t i = 0; i < N_SLOTS; ++i) {{
+        if (slots[i].name != NULL && strcmp(slots[i].name, name) == 0) {{
+            *slot = i;
+            return true;
+        }}
+    }}
+
+    return false;
+}}
+
+static double now(void) {{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}}
+
+static double bench(bool (*find)(const char *, size_t *), size_t lookups) {{
+    volatile size_t sink = 0;
+
+    const double start = now();
+    for (size_t i = 0; i < lookups; ++i) {{
+        size_t slot;
+        if (!find(names[i % N_NAMES], &slot)) {{
+            return -1;
+        }}
+        sink += slot;
+    }}
+
+    (void)sink;
+    return (now() - start) / lookups;
+}}
+
+int main(void) {{
+    const double linear  = bench(find_linear, {lookups});
+    const double perfect = bench(find_slot, {lookups});
+
+    if (linear < 0 || perfect < 0) {{
+        return 1;
+    }}
+
+    printf("%.1f %.1f\\n", linear, perfect);
+    return 0;
+}}
+"""
+
+
+def make_names(count: int) -> list[str]:
+    """Distinct, deterministic names, as long as real ones."""
+    return [f"asset_{i:0{NAME_LENGTH - len('asset_')}d}" for i in range(count)]
+
+
+def c_source(names: list[str], lookups: int) -> str:
+    """Program looking names up on the table generated for them."""
+    seeds, slots = perfect_hash(names)
+
+    return C_SOURCE.format(
+        names=", ".join(f'"{name}"' for name in names),
+        seeds=", ".join(map(str, seeds)),
+        slots=", ".join(
+            f'{{0x{slot_hash(seeds, name):08X}, "{name}"}}' if name is not None else "{0, NULL}" for name in slots
+        ),
+        lookups=lookups,
+    )
+
+
+class QpBench(BaseCommand):
+    """Time the generation of asset tables, and lookups on them against a linear search."""
+
+    @classmethod
+    def add_args(cls, parser: ArgumentParser) -> None:
+        """Command-specific arguments."""
+        parser.add_argument(
+            "--counts",
+            help="amounts of assets to measure",
+            default=[30, 100, 1000],
+            metavar="N",
+            nargs="+",
+            type=int,
+        )
+
+        parser.add_argument(
+            "--lookups",
+            help="lookups to average over",
+            default=2_000_000,
+            metavar="N",
+            type=int,
+        )
+
+        parser.add_argument(
+            "--cc",
+            help="C compiler to build the lookup harness with",
+            default="cc",
+        )
+
+        return super().add_args(parser)
+
+    def run(self, arguments: Namespace) -> Result[None, str]:
+        """Entrypoint."""
+        sys.stdout.write("names | generation (s) | linear strcmp (ns) | perfect hash (ns)\n")
+
+        with tempfile.TemporaryDirectory() as tmp:
+            source = Path(tmp) / "bench.c"
+            binary = Path(tmp) / "bench"
+
+            for count in arguments.counts:
+                names = make_names(count)
+
+                start = time.perf_counter()
+                try:
+                    code = c_source(names, arguments.lookups)
+                except ValueError as e:
+                    return Err(str(e))
+                generation = time.perf_counter() - start
+
+                source.write_text(code)
+
+                try:
+                    subprocess.run(
+                        [arguments.cc, "-O2", "-o", str(binary), str(source)],
+                        check=True,
+                        capture_output=True,
+                        text=True,
+                    )
+                    output = subprocess.run(
+                        [str(binary)],
+                        check=True,
+                        capture_output=True,
+                        text=True,
+                    ).stdout
+                except OSError as e:
+                    return Err(str(e))
+                except subprocess.CalledProcessError as e:
+                    return Err(f"{e.cmd[0]} failed:\n{e.stderr}")
+
+                linear, perfect = output.split()
+                sys.stdout.write(f"{count:>5} | {generation:>14.2f} | {linear:>18} | {perfect:>17}\n")
+                sys.stdout.flush()
+
+        return Ok(None)
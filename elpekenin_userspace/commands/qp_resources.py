@@ -2,6 +2,7 @@
 
 from __future__ import annotations
 
+import math
 from typing import TYPE_CHECKING
 
 from elpekenin_userspace import args
@@ -19,6 +20,24 @@ if TYPE_CHECKING:
 
 OUTPUT_NAME = "qp_resources"
 
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+# seeds and slot indices are stored as uint16_t
+MAX_SEED = 1 << 16
+MAX_SLOTS = 1 << 16
+# average amount of names sharing a seed
+BUCKET_SIZE = 4
+
+TABLES = {
+    "fonts": "qp_fonts_table",
+    "images": "qp_images_table",
+}
+
+COUNTS = {
+    "fonts": "QP_NUM_FONTS",
+    "images": "QP_NUM_IMAGES",
+}
+
 
 def find_assets_impl(assets: AssetsDictT, path: Path) -> None:
     """Collect all assets in the given directory."""
@@ -52,6 +71,82 @@ def asset_name(type_: str, path: Path) -> str:
     return f"{type_}_{name}"
 
 
+def asset_hash(seed: int, name: str) -> int:
+    """Hash a name, must match `qp_asset_hash` in the firmware."""
+    hash_ = FNV_OFFSET ^ seed
+
+    for byte in name.encode():
+        hash_ ^= byte
+        hash_ = (hash_ * FNV_PRIME) & 0xFFFFFFFF
+
+    return hash_
+
+
+def slot_hash(seeds: list[int], name: str) -> int:
+    """Hash that places a name on the table, must match `find_slot` in the firmware."""
+    bucket = asset_hash(0, name) % len(seeds)
+    return asset_hash(seeds[bucket], name)
+
+
+def place_bucket(bucket: list[str], slots: list[str | None]) -> int | None:
+    """Find a seed that puts every name in the bucket on a different free slot, and take those slots."""
+    size = len(slots)
+
+    for seed in range(MAX_SEED):
+        positions = [asset_hash(seed, name) % size for name in bucket]
+
+        if len(set(positions)) != len(positions) or any(slots[position] is not None for position in positions):
+            continue
+
+        for name, position in zip(bucket, positions):
+            slots[position] = name
+
+        return seed
+
+    return None
+
+
+def perfect_hash(names: list[str]) -> tuple[list[int], list[str | None]]:
+    """Map every name to a different slot, growing the table if needed.
+
+    Hash and displace: names are grouped in buckets by a first hash, then each bucket gets the seed used (on a second
+    hash) to place its names. Biggest buckets are placed first, while most slots are still free. This scales to
+    thousands of names with a table barely bigger than their count, a single seed does not.
+    """
+    n_buckets = max(1, math.ceil(len(names) / BUCKET_SIZE))
+    size = max(1, len(names))
+
+    buckets: list[list[str]] = [[] for _ in range(n_buckets)]
+    for name in names:
+        buckets[asset_hash(0, name) % n_buckets].append(name)
+
+    while size <= MAX_SLOTS:
+        slots: list[str | None] = [None] * size
+        seeds = [0] * n_buckets
+
+        for i in sorted(range(n_buckets), key=lambda i: len(buckets[i]), reverse=True):
+            if not buckets[i]:
+                continue
+
+            seed = place_bucket(buckets[i], slots)
+            if seed is None:
+                break
+
+            seeds[i] = seed
+        else:
+            return seeds, slots
+
+        size += max(1, size // 16)
+
+    msg = f"Could not fit {len(names)} assets in {MAX_SLOTS} slots, index table uses uint16_t"
+    raise ValueError(msg)
+
+
+def short_name(type_: str, path: Path) -> str:
+    """Name used to look up an asset in the firmware."""
+    return asset_name(type_, path).removeprefix("font_").removeprefix("gfx_")
+
+
 def gen_h_file(file: Path, assets: AssetsDictT) -> None:
     """Create contents for H file."""
     with file.open("w") as f:
@@ -71,7 +166,24 @@ def gen_h_file(file: Path, assets: AssetsDictT) -> None:
                 ],
             )
 
-        f.write("void load_qp_resources(void);\n")
+        f.writelines(
+            [
+                '#include "elpekenin/qp/assets.h"\n',
+                "\n",
+            ],
+        )
+
+        for i, (key, paths) in enumerate(assets.items()):
+            _, slots = perfect_hash([short_name(key, p) for p in paths])
+            table = TABLES[key]
+            f.writelines(
+                [
+                    "\n" if i else "",
+                    f"#define {COUNTS[key]} {len(paths)}\n",
+                    f"#define {table.upper()}_SIZE {len(slots)}\n",
+                    f"extern const qp_asset_table_t {table};\n",
+                ],
+            )
 
 
 def gen_c_file(file: Path, assets: AssetsDictT) -> None:
@@ -83,32 +195,38 @@ def gen_c_file(file: Path, assets: AssetsDictT) -> None:
                 "\n",
                 f'#include "generated/{OUTPUT_NAME}.h"\n',
                 "\n",
-                '#include "elpekenin/qp/assets.h"\n',  # set_{font,image}_by_name
-                "\n",
-                "void load_qp_resources(void) {",
             ],
         )
 
-        for key, paths in assets.items():
-            load = "qp_load_font_mem" if key == "fonts" else "qp_load_image_mem"
-            store = "set_font_by_name" if key == "fonts" else "set_image_by_name"
-
+        for i, (key, paths) in enumerate(assets.items()):
+            data = {short_name(key, p): asset_name(key, p) for p in paths}
+            seeds, slots = perfect_hash(list(data))
+            # dense index -> slot mapping, so that get_*_by_index doesn't walk the table
+            order = ", ".join(str(slots.index(name)) for name in sorted(data)) or "0"
             f.writelines(
                 [
-                    "\n",
-                    f"    // {key}\n",
+                    "\n" if i else "",
+                    f"const qp_asset_table_t {TABLES[key]} = {{\n",
+                    f"    .buckets = {len(seeds)},\n",
+                    f"    .seeds   = (const uint16_t[]){{{', '.join(map(str, seeds))}}},\n",
+                    f"    .size    = {len(slots)},\n",
+                    "    .slots   = (const qp_asset_slot_t[]){\n",
+                    *(
+                        (
+                            f"        [{j}] = {{.hash = 0x{slot_hash(seeds, name):08X}, "
+                            f'.name = "{name}", .data = {data[name]}}},\n'
+                        )
+                        if name is not None
+                        else f"        [{j}] = {{.hash = 0, .name = NULL, .data = NULL}},\n"
+                        for j, name in enumerate(slots)
+                    ),
+                    "    },\n",
+                    f"    .count   = {len(data)},\n",
+                    f"    .order   = (const uint16_t[]){{{order}}},\n",
+                    "};\n",
                 ],
             )
 
-            for p in paths:
-                asset = asset_name(key, p)
-                name = asset.removeprefix("font_").removeprefix("gfx_")
-                f.write(
-                    f'    {store}("{name}", (void *){load}({asset}));\n',
-                )
-
-        f.write("}\n")
-
 
 def gen_mk_file(file: Path, assets: AssetsDictT) -> None:
     """Create contents for MK file."""
@@ -0,0 +1,237 @@
+"""Subcommand to draw an image on the keyboard's displays, streaming it over XAP."""
+
+from __future__ import annotations
+
+import argparse
+import sys
+from typing import TYPE_CHECKING
+
+from elpekenin_userspace import args
+from elpekenin_userspace.commands import BaseCommand
+from elpekenin_userspace.qp_stream import (
+    PALETTE_SIZE,
+    Encoding,
+    Sender,
+    begin_payload,
+    encode,
+    palette_payloads,
+    rgb565,
+)
+from elpekenin_userspace.result import Err, Ok
+from elpekenin_userspace.xap_client import (
+    BROADCAST_TOKEN,
+    HidTransport,
+    SocketTransport,
+    Tokens,
+    parse_response,
+    routes,
+)
+
+try:
+    import hjson  # type: ignore[import-untyped]
+    from PIL import Image
+except ImportError:
+    HAS_DEPS = False
+else:
+    HAS_DEPS = True
+
+if TYPE_CHECKING:
+    from argparse import ArgumentParser, Namespace
+    from pathlib import Path
+
+    from elpekenin_userspace.result import Result
+    from elpekenin_userspace.xap_client import Response, Route, Transport
+
+RESOLVE = "quantum_painter_id/resolve"
+BEGIN = "quantum_painter_id/stream_begin"
+PALETTE = "quantum_painter_id/stream_palette"
+DATA = "quantum_painter_id/stream_data"
+
+# `kind` argument of resolve
+DEVICE_KIND = 0
+
+
+class Client:
+    """Send requests on a transport, one route at a time."""
+
+    def __init__(self, transport: Transport, timeout: float) -> None:
+        """Initialize an instance."""
+        self.transport = transport
+        self.timeout = timeout
+        self.tokens = Tokens()
+
+    def send(self, route: Route, payload: bytes) -> None:
+        """Send a request, without waiting for its answer."""
+        self.transport.send(route.request_raw(self.tokens(), payload))
+
+    def receive(self) -> Response:
+        """Wait for the next answer, skipping broadcasts (eg: logs)."""
+        while True:
+            report = self.transport.receive(self.timeout)
+            if report is None:
+                msg = "No answer from the device"
+                raise TimeoutError(msg)
+
+            response = parse_response(report)
+            if response.token != BROADCAST_TOKEN:
+                return response
+
+    def call(self, route: Route, payload: bytes) -> Response:
+        """Send a request and wait for its answer."""
+        self.send(route, payload)
+        return self.receive()
+
+
+def read_pixels(path: Path) -> tuple[int, int, list[bytes]]:
+    """Size of an image, and its pixels as (big endian) RGB565."""
+    with Image.open(path) as image:
+        rgb = image.convert("RGB")
+        pixels = [rgb565(*pixel) for pixel in rgb.getdata()]
+        return rgb.width, rgb.height, pixels
+
+
+class QpStream(BaseCommand):
+    """Draw an image on a display, streaming it over XAP."""
+
+    @classmethod
+    def add_args(cls, parser: ArgumentParser) -> None:
+        """Command-specific arguments."""
+        parser.add_argument(
+            "image",
+            help="image to be drawn, in any format supported by pillow",
+            type=args.File(require_existence=True),
+        )
+
+        parser.add_argument(
+            "--file",
+            help="specification file",
+            metavar="FILE",
+            required=True,
+            default=argparse.SUPPRESS,
+            type=args.File(
+                require_existence=True,
+                suffix=".hjson",
+            ),
+        )
+
+        parser.add_argument(
+            "--device",
+            help="name of the display, as registered on the firmware",
+            required=True,
+        )
+
+        parser.add_argument(
+            "--x",
+            help="horizontal position of the image's top left corner",
+            type=int,
+            default=0,
+        )
+
+        parser.add_argument(
+            "--y",
+            help="vertical position of the image's top left corner",
+            type=int,
+            default=0,
+        )
+
+        parser.add_argument(
+            "--palette-size",
+            help="most colors to use a palette with, must not exceed QP_STREAM_PALETTE_SIZE",
+            type=int,
+            default=PALETTE_SIZE,
+        )
+
+        parser.add_argument(
+            "--window",
+            help="data requests in flight",
+            type=int,
+            default=8,
+        )
+
+        parser.add_argument(
+            "--timeout",
+            help="seconds to wait for an answer",
+            type=float,
+            default=1,
+        )
+
+        parser.add_argument(
+            "--socket",
+            help="talk to a stand-in for the firmware at HOST:PORT, instead of a real device",
+            metavar="HOST:PORT",
+        )
+
+        return super().add_args(parser)
+
+    def run(self, arguments: Namespace) -> Result[None, str]:
+        """Entrypoint."""
+        if not HAS_DEPS:
+            return Err("Dependencies missing")
+
+        file: Path = arguments.file
+        by_name = {route.name: route for route in routes(hjson.loads(file.read_text()))}
+
+        missing = [name for name in (RESOLVE, BEGIN, PALETTE, DATA) if name not in by_name]
+        if missing:
+            return Err(f"Routes not found: {', '.join(missing)}")
+
+        width, height, pixels = read_pixels(arguments.image)
+        encoding, palette, chunks = encode(pixels, arguments.palette_size)
+
+        transport: Transport
+        try:
+            if arguments.socket is not None:
+                host, _, port = arguments.socket.rpartition(":")
+                transport = SocketTransport(host, int(port))
+            else:
+                transport = HidTransport()
+        except (OSError, RuntimeError) as e:
+            return Err(str(e))
+
+        client = Client(transport, arguments.timeout)
+        try:
+            return self.stream(client, arguments, by_name, (width, height), encoding, palette, chunks)
+        except (OSError, RuntimeError) as e:
+            return Err(str(e))
+        finally:
+            transport.close()
+
+    def stream(  # noqa: PLR0913
+        self,
+        client: Client,
+        arguments: Namespace,
+        by_name: dict[str, Route],
+        size: tuple[int, int],
+        encoding: Encoding,
+        palette: list[bytes],
+        chunks: list[bytes],
+    ) -> Result[None, str]:
+        """Draw the (already encoded) image."""
+        name = arguments.device.encode()
+        response = client.call(by_name[RESOLVE], by_name[RESOLVE].payload({"kind": DEVICE_KIND, "name": name}))
+        if not response.success:
+            return Err(f"Device '{arguments.device}' not found")
+
+        device_id = response.payload[0]
+
+        width, height = size
+        region = (arguments.x, arguments.y, arguments.x + width - 1, arguments.y + height - 1)
+        if not client.call(by_name[BEGIN], begin_payload(device_id, region, encoding)).success:
+            return Err("Could not start the stream")
+
+        for payload in palette_payloads(palette):
+            if not client.call(by_name[PALETTE], payload).success:
+                return Err("Could not set the palette")
+
+        sender = Sender(
+            send=lambda payload: client.send(by_name[DATA], payload),
+            receive=lambda: client.receive().payload,
+            window=arguments.window,
+        )
+        retries = sender.run(chunks)
+
+        sys.stdout.write(
+            f"{width}x{height} pixels, {encoding.name}, {len(palette)} colors, "
+            f"{len(chunks)} chunks ({retries} re-sent)\n",
+        )
+        return Ok(None)
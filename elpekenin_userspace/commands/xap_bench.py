@@ -0,0 +1,316 @@
+"""Subcommand to measure latency and throughput of XAP routes."""
+
+from __future__ import annotations
+
+import argparse
+import fnmatch
+import statistics
+import sys
+import time
+from collections import deque
+from dataclasses import dataclass, field
+from typing import TYPE_CHECKING
+
+from elpekenin_userspace import args
+from elpekenin_userspace.commands import BaseCommand
+from elpekenin_userspace.result import Err, Ok
+from elpekenin_userspace.xap_client import (
+    HidTransport,
+    Simulator,
+    SocketTransport,
+    Tokens,
+    parse_response,
+    routes,
+)
+
+try:
+    import hjson  # type: ignore[import-untyped]
+except ImportError:
+    HAS_HJSON = False
+else:
+    HAS_HJSON = True
+
+if TYPE_CHECKING:
+    from argparse import ArgumentParser, Namespace
+    from collections.abc import Mapping
+    from pathlib import Path
+
+    from elpekenin_userspace.result import Result
+    from elpekenin_userspace.xap_client import Route, Transport
+
+COMPLETION = "quantum_painter/completion"
+PENDING = 1
+SUCCESS = 2
+
+# seconds between polls for a deferred request, doubling up to the max
+POLL_MIN = 0.001
+POLL_MAX = 0.032
+
+
+def value(raw: str) -> tuple[str, int | bytes]:
+    """Parse a `name=value` argument, value being an integer or (otherwise) a string."""
+    name, sep, text = raw.partition("=")
+    if not sep:
+        msg = f"expected 'name=value', got '{raw}'"
+        raise argparse.ArgumentTypeError(msg)
+
+    try:
+        return name, int(text, 0)
+    except ValueError:
+        return name, text.encode()
+
+
+@dataclass
+class Stats:
+    """Measurements for a route."""
+
+    route: str
+    latencies: list[float] = field(default_factory=list)
+    failures: int = 0
+    deferred: int = 0
+    elapsed: float = 0
+
+    def row(self) -> str:
+        """Format as a line of the table."""
+        if not self.latencies:
+            return f"{self.route:<40} {0:>6} {self.failures:>6} {self.deferred:>6}"
+
+        ms = sorted(latency * 1000 for latency in self.latencies)
+        p95 = ms[min(len(ms) - 1, int(len(ms) * 0.95))]
+        rate = len(ms) / self.elapsed if self.elapsed else 0
+
+        return (
+            f"{self.route:<40} {len(ms):>6} {self.failures:>6} {self.deferred:>6}"
+            f" {ms[0]:>8.2f} {statistics.median(ms):>8.2f} {p95:>8.2f} {ms[-1]:>8.2f} {rate:>9.1f}"
+        )
+
+
+HEADER = (
+    f"{'route':<40} {'ok':>6} {'fail':>6} {'defer':>6}"
+    f" {'min':>8} {'p50':>8} {'p95':>8} {'max':>8} {'req/s':>9}"
+)
+
+POLL_NOTE = (
+    f"note: latency of deferred requests includes polling for their completion, up to {POLL_MAX * 1000:.0f}ms"
+    " between polls\n"
+)
+
+
+class Bench:
+    """Send requests, with up to `window` of them in flight."""
+
+    def __init__(
+        self,
+        transport: Transport,
+        values: Mapping[str, int | bytes],
+        timeout: float,
+        completion: Route | None,
+    ) -> None:
+        """Initialize an instance."""
+        self.transport = transport
+        self.values = values
+        self.timeout = timeout
+        self.completion = completion
+        self.tokens = Tokens()
+
+    def wait_completion(self, completion_id: int, others: deque[bytes]) -> bool:
+        """Poll a deferred request until it is done, returns whether it succeeded.
+
+        Reports for other requests received meanwhile are put on `others`, for the caller to handle them.
+        """
+        if self.completion is None:
+            return True
+
+        delay = POLL_MIN
+        while True:
+            token = self.tokens()
+            self.transport.send(self.completion.request(token, {"id": completion_id}))
+
+            while True:
+                report = self.transport.receive(self.timeout)
+                if report is None:
+                    return False
+
+                response = parse_response(report)
+                if response.token == token:
+                    break
+
+                others.append(report)
+
+            if response.payload[:1] != bytes([PENDING]):
+                return response.payload[:1] == bytes([SUCCESS])
+
+            time.sleep(delay)
+            delay = min(delay * 2, POLL_MAX)
+
+    def run(self, route: Route, count: int, window: int) -> Stats:
+        """Measure a route."""
+        stats = Stats(route.name)
+        in_flight: dict[int, float] = {}
+        backlog: deque[bytes] = deque()
+        sent = 0
+
+        start = time.perf_counter()
+        while sent < count or in_flight:
+            while sent < count and len(in_flight) < window:
+                token = self.tokens()
+                in_flight[token] = time.perf_counter()
+                self.transport.send(route.request(token, self.values))
+                sent += 1
+
+            report = backlog.popleft() if backlog else self.transport.receive(self.timeout)
+            if report is None:
+                # lost, do not wait for them any longer
+                stats.failures += len(in_flight)
+                in_flight.clear()
+                continue
+
+            response = parse_response(report)
+            sent_at = in_flight.pop(response.token, None)
+            if sent_at is None:
+                continue
+
+            ok = response.success
+            if ok and response.deferred:
+                stats.deferred += 1
+                ok = self.wait_completion(response.completion_id, backlog)
+
+            if ok:
+                stats.latencies.append(time.perf_counter() - sent_at)
+            else:
+                stats.failures += 1
+
+        stats.elapsed = time.perf_counter() - start
+        return stats
+
+
+class XapBench(BaseCommand):
+    """Measure latency and throughput of XAP routes."""
+
+    @classmethod
+    def add_args(cls, parser: ArgumentParser) -> None:
+        """Command-specific arguments."""
+        parser.add_argument(
+            "--file",
+            help="specification file",
+            metavar="FILE",
+            required=True,
+            default=argparse.SUPPRESS,
+            type=args.File(
+                require_existence=True,
+                suffix=".hjson",
+            ),
+        )
+
+        transport = parser.add_mutually_exclusive_group()
+        transport.add_argument(
+            "--socket",
+            help="talk to a stand-in for the firmware at HOST:PORT, instead of a real device",
+            metavar="HOST:PORT",
+        )
+        transport.add_argument(
+            "--simulate",
+            help=(
+                "talk to a local echo server instead of a real device: no handler runs, every request gets an empty"
+                " success after this many milliseconds (measures the host side only)"
+            ),
+            metavar="MS",
+            type=float,
+        )
+
+        parser.add_argument(
+            "--route",
+            help="glob of the routes to measure, eg: 'quantum_painter_id/*' (can be repeated)",
+            action="append",
+            default=[],
+        )
+
+        parser.add_argument(
+            "--set",
+            help="value for request fields with this name, eg: device_id=0 or device_name=ili9163 (can be repeated)",
+            metavar="NAME=VALUE",
+            action="append",
+            type=value,
+            default=[],
+        )
+
+        parser.add_argument(
+            "--count",
+            help="requests per route",
+            type=int,
+            default=100,
+        )
+
+        parser.add_argument(
+            "--window",
+            help="requests in flight, 1 measures round-trip latency",
+            type=int,
+            default=1,
+        )
+
+        parser.add_argument(
+            "--timeout",
+            help="seconds to wait for an answer",
+            type=float,
+            default=1,
+        )
+
+        parser.add_argument(
+            "--wait-deferred",
+            help="poll deferred requests until done, measuring their actual duration",
+            action="store_true",
+        )
+
+        return super().add_args(parser)
+
+    def run(self, arguments: Namespace) -> Result[None, str]:
+        """Entrypoint."""
+        if not HAS_HJSON:
+            return Err("Dependencies missing")
+
+        file: Path = arguments.file
+        patterns: list[str] = arguments.route or ["*"]
+
+        all_routes = routes(hjson.loads(file.read_text()))
+        selected = [route for route in all_routes if any(fnmatch.fnmatch(route.name, pattern) for pattern in patterns)]
+        if not selected:
+            return Err("No route matched")
+
+        completion = None
+        if arguments.wait_deferred:
+            completion = next((route for route in all_routes if route.name == COMPLETION), None)
+            if completion is None:
+                return Err(f"'{COMPLETION}' route not found")
+
+        simulator = None
+        transport: Transport
+        try:
+            if arguments.simulate is not None:
+                simulator = Simulator(arguments.simulate / 1000)
+                transport = SocketTransport("127.0.0.1", simulator.port)
+            elif arguments.socket is not None:
+                host, _, port = arguments.socket.rpartition(":")
+                transport = SocketTransport(host, int(port))
+            else:
+                transport = HidTransport()
+        except (OSError, RuntimeError) as e:
+            if simulator is not None:
+                simulator.close()
+            return Err(str(e))
+
+        bench = Bench(transport, dict(arguments.set), arguments.timeout, completion)
+
+        if completion is not None:
+            sys.stdout.write(POLL_NOTE)
+
+        sys.stdout.write(HEADER + "\n")
+        try:
+            for route in selected:
+                stats = bench.run(route, arguments.count, arguments.window)
+                sys.stdout.write(stats.row() + "\n")
+        finally:
+            transport.close()
+            if simulator is not None:
+                simulator.close()
+
+        return Ok(None)
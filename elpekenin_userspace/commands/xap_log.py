@@ -0,0 +1,68 @@
+"""Subcommand to print the logs that the keyboard broadcasts over XAP."""
+
+from __future__ import annotations
+
+import sys
+from typing import TYPE_CHECKING
+
+from elpekenin_userspace.commands import BaseCommand
+from elpekenin_userspace.result import Err, Ok
+from elpekenin_userspace.xap_client import (
+    HidTransport,
+    LogStream,
+    SocketTransport,
+)
+
+if TYPE_CHECKING:
+    from argparse import ArgumentParser, Namespace
+
+    from elpekenin_userspace.result import Result
+    from elpekenin_userspace.xap_client import Transport
+
+# seconds, only used to check for Ctrl+C now and then
+RECEIVE_TIMEOUT = 0.5
+
+
+class XapLog(BaseCommand):
+    """Print logs sent by the keyboard over XAP, until interrupted."""
+
+    @classmethod
+    def add_args(cls, parser: ArgumentParser) -> None:
+        """Command-specific arguments."""
+        parser.add_argument(
+            "--socket",
+            help="talk to a stand-in for the firmware at HOST:PORT, instead of a real device",
+            metavar="HOST:PORT",
+        )
+
+        return super().add_args(parser)
+
+    def run(self, arguments: Namespace) -> Result[None, str]:
+        """Entrypoint."""
+        transport: Transport
+        try:
+            if arguments.socket is not None:
+                host, _, port = arguments.socket.rpartition(":")
+                transport = SocketTransport(host, int(port))
+            else:
+                transport = HidTransport()
+        except (OSError, RuntimeError) as e:
+            return Err(str(e))
+
+        stream = LogStream()
+        try:
+            while True:
+                report = transport.receive(RECEIVE_TIMEOUT)
+                if report is None:
+                    continue
+
+                for line in stream.feed(report):
+                    sys.stdout.write(line + "\n")
+
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            transport.close()
+
+        return Ok(None)
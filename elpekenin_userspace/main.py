@@ -23,10 +23,14 @@ from elpekenin_userspace.commands.jsonschema import Jsonschema
 from elpekenin_userspace.commands.keycode_str import KeycodeStr
 from elpekenin_userspace.commands.micropython import Micropython
 from elpekenin_userspace.commands.py2c import Py2C
+from elpekenin_userspace.commands.qp_bench import QpBench
 from elpekenin_userspace.commands.qp_resources import QpResources
+from elpekenin_userspace.commands.qp_stream import QpStream
 from elpekenin_userspace.commands.stubs import Stubs
 from elpekenin_userspace.commands.tidy import Tidy
 from elpekenin_userspace.commands.xap import Xap
+from elpekenin_userspace.commands.xap_bench import XapBench
+from elpekenin_userspace.commands.xap_log import XapLog
 from elpekenin_userspace.result import is_err
 
 if TYPE_CHECKING:
@@ -40,11 +44,15 @@ SUBCOMMANDS: dict[str, type[BaseCommand]] = {
     "jsonschema": Jsonschema,
     "keycode_str": KeycodeStr,
     "micropython": Micropython,
+    "qp_bench": QpBench,
     "qp_resources": QpResources,
+    "qp_stream": QpStream,
     "py2c": Py2C,
     "stubs": Stubs,
     "tidy": Tidy,
     "xap": Xap,
+    "xap_bench": XapBench,
+    "xap_log": XapLog,
 }
 
 
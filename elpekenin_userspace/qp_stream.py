@@ -0,0 +1,214 @@
+"""Host side of QP's pixel streams (see `elpekenin/qp/stream.h`).
+
+Pixels are given as `bytes` in the display's native format (eg: big endian RGB565), and get turned into the payloads
+for the `stream_begin`, `stream_palette` and `stream_data` XAP routes.
+"""
+
+from __future__ import annotations
+
+import enum
+import struct
+from typing import TYPE_CHECKING
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Sequence
+
+RUN_FLAG = 0x80
+MAX_COUNT = 0x80
+
+# times the same chunk can get rejected before giving up (eg: display failing to draw it)
+MAX_REJECTS = 5
+
+# room for data on each XAP request
+DATA_SIZE = 54
+# default of QP_STREAM_PALETTE_SIZE
+PALETTE_SIZE = 256
+PALETTE_COLORS_PER_REQUEST = 27
+
+
+class Encoding(enum.IntEnum):
+    """How pixels are encoded, must match `qp_stream_encoding_t`."""
+
+    RLE = 0
+    PALETTE_RLE = 1
+
+
+def rgb565(red: int, green: int, blue: int) -> bytes:
+    """Convert a RGB888 color into (big endian) RGB565."""
+    value = ((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3)
+    return value.to_bytes(2, "big")
+
+
+def run_length(values: Sequence[bytes], start: int) -> int:
+    """How many times the value at `start` is repeated (capped to a token's size)."""
+    end = start + 1
+    while end < len(values) and values[end] == values[start] and end - start < MAX_COUNT:
+        end += 1
+
+    return end - start
+
+
+def pack(values: Sequence[bytes]) -> list[bytes]:
+    """Run-length encode values into chunks of data, without splitting any token."""
+    value_size = len(values[0]) if values else 1
+
+    ret: list[bytes] = []
+    current = bytearray()
+    literal: list[bytes] = []
+
+    def emit(token: bytes) -> None:
+        if len(current) + len(token) > DATA_SIZE:
+            ret.append(bytes(current))
+            current.clear()
+
+        current.extend(token)
+
+    def flush_literal() -> None:
+        if literal:
+            emit(bytes([len(literal) - 1]) + b"".join(literal))
+            literal.clear()
+
+    def max_literal() -> int:
+        # fill what is left of the current chunk, or a whole new one
+        room = (DATA_SIZE - len(current) - 1) // value_size
+        if room <= 0:
+            room = (DATA_SIZE - 1) // value_size
+
+        return min(MAX_COUNT, room)
+
+    i = 0
+    while i < len(values):
+        count = run_length(values, i)
+
+        # a run of 2 is not worth breaking a literal for
+        if count > 2:  # noqa: PLR2004
+            flush_literal()
+            emit(bytes([RUN_FLAG | (count - 1)]) + values[i])
+            i += count
+            continue
+
+        literal.append(values[i])
+        if len(literal) == max_literal():
+            flush_literal()
+
+        i += 1
+
+    flush_literal()
+    if current:
+        ret.append(bytes(current))
+
+    return ret
+
+
+def encode(pixels: Sequence[bytes], palette_size: int = PALETTE_SIZE) -> tuple[Encoding, list[bytes], list[bytes]]:
+    """Pick the best encoding for some pixels, returns it along with the palette (if any) and the chunks of data.
+
+    `palette_size` must not be bigger than `QP_STREAM_PALETTE_SIZE` on the firmware.
+    """
+    palette = sorted(set(pixels))
+
+    if len(palette) > palette_size:
+        return Encoding.RLE, [], pack(pixels)
+
+    index = {color: bytes([i]) for i, color in enumerate(palette)}
+    return Encoding.PALETTE_RLE, palette, pack([index[pixel] for pixel in pixels])
+
+
+#
+# payloads
+#
+
+
+def begin_payload(device_id: int, region: tuple[int, int, int, int], encoding: Encoding) -> bytes:
+    """Payload for `stream_begin`, region is (left, top, right, bottom), inclusive."""
+    return struct.pack("<B4HB", device_id, *region, encoding)
+
+
+def palette_payloads(palette: Sequence[bytes]) -> list[bytes]:
+    """Payloads for `stream_palette`."""
+    ret: list[bytes] = []
+
+    for start in range(0, len(palette), PALETTE_COLORS_PER_REQUEST):
+        colors = palette[start : start + PALETTE_COLORS_PER_REQUEST]
+        data = b"".join(colors).ljust(DATA_SIZE, b"\0")
+        ret.append(bytes([start, len(colors)]) + data)
+
+    return ret
+
+
+def data_payload(seq: int, chunk: bytes) -> bytes:
+    """Payload for `stream_data`."""
+    return struct.pack("<HB", seq & 0xFFFF, len(chunk)) + chunk.ljust(DATA_SIZE, b"\0")
+
+
+def parse_ack(response: bytes) -> tuple[bool, int]:
+    """Parse the answer to `stream_data`: whether chunk was accepted and next sequence number."""
+    accepted, expected = struct.unpack("<?H", response[:3])
+    return accepted, expected
+
+
+#
+# transport
+#
+
+
+class Sender:
+    """Send chunks with a window of requests in flight, going back to the last accepted one upon errors."""
+
+    def __init__(
+        self,
+        send: Callable[[bytes], None],
+        receive: Callable[[], bytes],
+        window: int = 8,
+    ) -> None:
+        """Transport is given as callbacks to send a `stream_data` payload, and to read its answer."""
+        self.send = send
+        self.receive = receive
+        self.window = window
+
+    def run(self, data: Sequence[bytes]) -> int:
+        """Send all chunks, returns how many were re-sent.
+
+        Raises RuntimeError if a chunk keeps getting rejected.
+        """
+        base = 0  # first chunk not acknowledged
+        next_ = 0  # next chunk to be sent
+        in_flight = 0
+        retries = 0
+        rejects = 0
+
+        while base < len(data):
+            while next_ < len(data) and next_ - base < self.window:
+                self.send(data_payload(next_, data[next_]))
+                next_ += 1
+                in_flight += 1
+
+            accepted, expected = parse_ack(self.receive())
+            in_flight -= 1
+
+            # sequence numbers are 16 bits, map back into an index
+            expected = base + ((expected - base) & 0xFFFF)
+
+            if accepted:
+                if expected > base:
+                    rejects = 0
+                base = max(base, expected)
+                continue
+
+            rejects += 1
+            if rejects == MAX_REJECTS:
+                msg = f"Chunk {expected} was rejected {MAX_REJECTS} times"
+                raise RuntimeError(msg)
+
+            # answers for the rest of the window are stale, wait for them before going back
+            for _ in range(in_flight):
+                self.receive()
+
+            in_flight = 0
+            retries += next_ - expected
+            base = next_ = expected
+
+        for _ in range(in_flight):
+            self.receive()
+
+        return retries
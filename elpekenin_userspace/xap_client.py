@@ -0,0 +1,331 @@
+"""Minimal host side of XAP: reading the spec, encoding requests and talking to a device.
+
+Only the user subsystem is covered, routes are taken from the hjson file also used for codegen.
+"""
+
+from __future__ import annotations
+
+import socket
+import struct
+import threading
+import time
+from dataclasses import dataclass
+from typing import TYPE_CHECKING, Any, Protocol
+
+try:
+    import hid  # type: ignore[import-untyped]
+except ImportError:
+    HAS_HID = False
+else:
+    HAS_HID = True
+
+if TYPE_CHECKING:
+    from collections.abc import Mapping
+
+REPORT_SIZE = 64
+USAGE_PAGE = 0xFF51
+USAGE = 0x0058
+
+USER_SUBSYSTEM = 0x03
+
+FLAG_SUCCESS = 1 << 0
+
+# payload of a deferred response: marker, completion id
+DEFERRED_PAYLOAD = struct.Struct("<BH")
+DEFERRED_MARKER = 0xDE  # must match XAP_DEFERRED_MARKER
+
+# token, length
+REQUEST_HEADER = struct.Struct("<HB")
+# token, flags, length
+RESPONSE_HEADER = struct.Struct("<HBB")
+
+# 0xFFFE and 0xFFFF are reserved for broadcasts
+FIRST_TOKEN = 0x0100
+LAST_TOKEN = 0xFFFD
+BROADCAST_TOKEN = 0xFFFF
+
+# token, type, length
+BROADCAST_HEADER = struct.Struct("<HBB")
+LOG_BROADCAST = 0x00
+
+SIZES = {
+    "u8": 1,
+    "u16": 2,
+    "u32": 4,
+}
+
+
+#
+# spec
+#
+
+
+@dataclass(frozen=True)
+class Member:
+    """A field in a request."""
+
+    type: str
+    name: str
+
+    @property
+    def size(self) -> int:
+        """Bytes taken by this field."""
+        if self.type.startswith("u8["):
+            return int(self.type[3:-1])
+
+        return SIZES[self.type]
+
+    def encode(self, value: int | bytes) -> bytes:
+        """Serialize a value for this field, padding (or truncating) it as needed."""
+        if isinstance(value, bytes):
+            return value[: self.size].ljust(self.size, b"\0")
+
+        return value.to_bytes(self.size, "little")
+
+
+@dataclass(frozen=True)
+class Route:
+    """A command on the user subsystem."""
+
+    path: tuple[int, ...]
+    name: str
+    members: tuple[Member, ...]
+
+    def payload(self, values: Mapping[str, int | bytes]) -> bytes:
+        """Arguments for this route, fields not in `values` are zero."""
+        return b"".join(member.encode(values.get(member.name, 0)) for member in self.members)
+
+    def request(self, token: int, values: Mapping[str, int | bytes]) -> bytes:
+        """Full report to be sent."""
+        return self.request_raw(token, self.payload(values))
+
+    def request_raw(self, token: int, payload: bytes) -> bytes:
+        """Full report to be sent, with arguments already serialized."""
+        body = bytes([USER_SUBSYSTEM, *self.path]) + payload
+        return (REQUEST_HEADER.pack(token, len(body)) + body).ljust(REPORT_SIZE, b"\0")
+
+
+def routes(spec: Mapping[str, Any]) -> list[Route]:
+    """Flatten the commands on a (parsed) spec file."""
+    ret: list[Route] = []
+
+    def walk(node: Mapping[str, Any], path: tuple[int, ...], prefix: str) -> None:
+        for key, child in node.get("routes", {}).items():
+            child_path = (*path, int(key, 0))
+            name = f"{prefix}{child['name']}"
+
+            if child["type"] == "router":
+                walk(child, child_path, f"{name}/")
+                continue
+
+            # only fixed-size requests can be generated, pixdata and friends are left out
+            if child.get("request_type", "struct") != "struct":
+                continue
+
+            members = tuple(Member(member["type"], member["name"]) for member in child.get("request_struct_members", []))
+            ret.append(Route(child_path, name, members))
+
+    walk(spec, (), "")
+    return ret
+
+
+#
+# responses
+#
+
+
+@dataclass(frozen=True)
+class Response:
+    """Answer from the device."""
+
+    token: int
+    flags: int
+    payload: bytes
+
+    @property
+    def success(self) -> bool:
+        """Whether request was successful."""
+        return bool(self.flags & FLAG_SUCCESS)
+
+    @property
+    def deferred(self) -> bool:
+        """Whether result is not known yet, payload is then a marker followed by the id to query it."""
+        return (
+            self.success
+            and len(self.payload) == DEFERRED_PAYLOAD.size
+            and self.payload[0] == DEFERRED_MARKER
+        )
+
+    @property
+    def completion_id(self) -> int:
+        """Id to query the result of a deferred request."""
+        _, completion_id = DEFERRED_PAYLOAD.unpack(self.payload)
+        return int(completion_id)
+
+
+def parse_response(report: bytes) -> Response:
+    """Parse a report sent by the device."""
+    token, flags, length = RESPONSE_HEADER.unpack_from(report)
+    start = RESPONSE_HEADER.size
+    return Response(token, flags, report[start : start + length])
+
+
+class LogStream:
+    """Rebuild lines out of log broadcasts, which are length-prefixed chunks of text that may split a line."""
+
+    def __init__(self) -> None:
+        """Initialize an instance."""
+        self.pending = b""
+
+    def feed(self, report: bytes) -> list[str]:
+        """Process a report, returns the lines it completed (if any)."""
+        token, type_, _ = BROADCAST_HEADER.unpack_from(report)
+        if token != BROADCAST_TOKEN or type_ != LOG_BROADCAST:
+            return []
+
+        start = BROADCAST_HEADER.size
+        length = report[start]
+        self.pending += report[start + 1 : start + 1 + length]
+
+        *lines, self.pending = self.pending.split(b"\n")
+        return [line.decode(errors="replace") for line in lines]
+
+
+class Tokens:
+    """Generate tokens to match responses with their requests."""
+
+    def __init__(self) -> None:
+        """Initialize an instance."""
+        self.next = FIRST_TOKEN
+
+    def __call__(self) -> int:
+        """Get a new token."""
+        ret = self.next
+
+        self.next += 1
+        if self.next > LAST_TOKEN:
+            self.next = FIRST_TOKEN
+
+        return ret
+
+
+#
+# transports
+#
+
+
+class Transport(Protocol):
+    """How reports get to the device (and back)."""
+
+    def send(self, report: bytes) -> None:
+        """Send a report."""
+
+    def receive(self, timeout: float) -> bytes | None:
+        """Read a report, None if none arrived in `timeout` seconds."""
+
+    def close(self) -> None:
+        """Release resources."""
+
+
+class HidTransport:
+    """Real device, over raw HID."""
+
+    def __init__(self) -> None:
+        """Open the first XAP interface found."""
+        if not HAS_HID:
+            msg = "'hid' is not installed"
+            raise RuntimeError(msg)
+
+        for info in hid.enumerate():
+            if info["usage_page"] == USAGE_PAGE and info["usage"] == USAGE:
+                self.device = hid.Device(path=info["path"])
+                return
+
+        msg = "No XAP device found"
+        raise RuntimeError(msg)
+
+    def send(self, report: bytes) -> None:
+        """Send a report (with report id 0 prepended)."""
+        self.device.write(b"\0" + report)
+
+    def receive(self, timeout: float) -> bytes | None:
+        """Read a report."""
+        data: bytes = self.device.read(REPORT_SIZE, timeout=int(timeout * 1000))
+        return data or None
+
+    def close(self) -> None:
+        """Close the device."""
+        self.device.close()
+
+
+class SocketTransport:
+    """Fixed-size reports over a TCP socket, eg: to a stand-in for the firmware."""
+
+    def __init__(self, host: str, port: int) -> None:
+        """Connect to the given address."""
+        self.socket = socket.create_connection((host, port))
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def send(self, report: bytes) -> None:
+        """Send a report."""
+        self.socket.sendall(report)
+
+    def receive(self, timeout: float) -> bytes | None:
+        """Read a report."""
+        self.socket.settimeout(timeout)
+
+        data = b""
+        try:
+            while len(data) < REPORT_SIZE:
+                chunk = self.socket.recv(REPORT_SIZE - len(data))
+                if not chunk:
+                    return None
+                data += chunk
+        except socket.timeout:
+            return None
+
+        return data
+
+    def close(self) -> None:
+        """Close the connection."""
+        self.socket.close()
+
+
+class Simulator:
+    """Echo server over TCP on localhost: answers every request with an empty success after a fixed delay.
+
+    No route handler runs, so payloads and deferred responses are never produced. Useful to check the overhead of the
+    host side, and to try out tools without a device.
+    """
+
+    def __init__(self, delay: float) -> None:
+        """Start listening on a random port."""
+        self.delay = delay
+
+        self.server = socket.create_server(("127.0.0.1", 0))
+        self.port: int = self.server.getsockname()[1]
+
+        self.thread = threading.Thread(target=self.serve, daemon=True)
+        self.thread.start()
+
+    def serve(self) -> None:
+        """Answer requests from a single client."""
+        connection, _ = self.server.accept()
+        connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+        with connection:
+            while True:
+                data = b""
+                while len(data) < REPORT_SIZE:
+                    chunk = connection.recv(REPORT_SIZE - len(data))
+                    if not chunk:
+                        return
+                    data += chunk
+
+                token, _ = REQUEST_HEADER.unpack_from(data)
+                time.sleep(self.delay)
+                connection.sendall(RESPONSE_HEADER.pack(token, FLAG_SUCCESS, 0).ljust(REPORT_SIZE, b"\0"))
+
+    def close(self) -> None:
+        """Stop listening."""
+        self.server.close()
@@ -7,6 +7,10 @@
 
 #include "elpekenin/sipo.h"
 
+#if IS_ENABLED(QP_EINK_DIFF)
+#    include "elpekenin/qp/eink.h"
+#endif
+
 // compat: include-dir-dependant #include fails
 #if IS_ENABLED(QUANTUM_PAINTER)
 #    include <drivers/painter/eink_panel/qp_eink_panel.h>
@@ -37,6 +41,12 @@ enum right_sipo_pins {
 
 uint8_t il91874_buffer[EINK_BYTES_REQD(IL91874_WIDTH, IL91874_HEIGHT)] = {0};
 
+#if IS_ENABLED(QP_EINK_DIFF)
+// what the panel is showing, to only refresh the regions that changed
+static uint8_t        il91874_previous[EINK_BYTES_REQD(IL91874_WIDTH, IL91874_HEIGHT)] = {0};
+static qp_eink_diff_t il91874_diff                                                     = {0};
+#endif
+
 painter_device_t il91874 = {0};
 painter_device_t ili9163 = {0};
 painter_device_t ili9341 = {0};
@@ -85,6 +95,10 @@ void keyboard_post_init_kb(void) {
         ret &= qp_init(il91874, IL91874_ROTATION);
         ret &= qp_power(il91874, true);
 
+#if IS_ENABLED(QP_EINK_DIFF)
+        ret &= qp_eink_diff_init(&il91874_diff, il91874, _IL91874_WIDTH, _IL91874_HEIGHT, il91874_buffer, il91874_previous);
+#endif
+
         printf("QP setup: %s\n", ret ? "ok" : "failed");
     }
 
@@ -19,6 +19,10 @@
 #include "elpekenin/signatures.h"
 #include "generated/qp_resources.h" // access to fonts/images
 
+#if IS_ENABLED(QP_EINK_DIFF)
+#    include "elpekenin/qp/eink.h"
+#endif
+
 #if CM_ENABLED(INDICATORS)
 #    include "elpekenin/indicators.h"
 #endif
@@ -45,10 +49,33 @@
 #if CM_ENABLED(UI)
 #    include "elpekenin/ui.h"
 extern ui_node_t root; // on ./ui.c
+
+// where the UI gets drawn, either the display itself or a framebuffer for it
+static painter_device_t ui_display = NULL;
 #endif
 
-STATIC_ASSERT(CM_ENABLED(BUILD_ID), "Must enable 'elpekenin/build_id'");
-#include "elpekenin/build_id.h"
+#if IS_ENABLED(QP_FRAMEBUFFER)
+#    include "elpekenin/qp/framebuffer.h"
+
+// RAM budget: RP2040 has 264KB, ~227KB of which hold data, bss and heap (see `elpekenin_rp2040.ld`)
+//   - ili9341 (UI):   240 * 320 * 2 bytes = 150KB
+//   - ili9163 (XAP):  130 * 130 * 2 bytes =  33KB
+//
+// both halves run the same firmware but only the right one has these displays, pixel buffers are
+// thus allocated from the heap when it boots, instead of being static and wasting ~183KB on the left
+// if allocation fails, drawing goes straight to the display
+#    define ILI9341_BUFFER_SIZE SURFACE_REQUIRED_BUFFER_BYTE_SIZE(ILI9341_WIDTH, ILI9341_HEIGHT, 16)
+#    define ILI9163_BUFFER_SIZE SURFACE_REQUIRED_BUFFER_BYTE_SIZE(ILI9163_WIDTH, ILI9163_HEIGHT, 16)
+
+#    if CM_ENABLED(UI)
+static uint8_t          ui_dirty[QP_FRAMEBUFFER_DIRTY_BYTES(ILI9341_WIDTH, ILI9341_HEIGHT)];
+static qp_framebuffer_t ui_framebuffer = {0};
+#    endif
+
+// ili9163 is only drawn over XAP, buffering it lets its updates be interleaved with the UI's ones
+static uint8_t          ili9163_dirty[QP_FRAMEBUFFER_DIRTY_BYTES(ILI9163_WIDTH, ILI9163_HEIGHT)];
+static qp_framebuffer_t ili9163_framebuffer = {0};
+#endif
 
 STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
 #include "elpekenin/logging.h"
@@ -103,57 +130,76 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 // helper functions
 //
 
+// compat: settings not defined if feature is off
+#if !IS_ENABLED(TOUCH_SCREEN)
+#    define TOUCH_FILTER_MIN_DISTANCE (0)
+#    define TOUCH_FILTER_MIN_INTERVAL (0)
+#endif
+
+static touch_filter_t touch_filter = {
+    .min_distance = TOUCH_FILTER_MIN_DISTANCE,
+    .min_interval = TOUCH_FILTER_MIN_INTERVAL,
+};
+
+static void send_touch_event(const void *msg, size_t msg_len) {
+    if (IS_ENABLED(XAP)) {
+        xap_broadcast_user(msg, msg_len);
+    }
+
+    if (IS_ENABLED(M5)) {
+        m5_send(msg, msg_len);
+    }
+}
+
 static uint32_t read_touch_callback(__unused uint32_t trigger_time, __unused void *cb_arg) {
     if (!IS_ENABLED(TOUCH_SCREEN) || is_keyboard_left()) {
         return 0;
     }
 
-    static touch_report_t last = {
+    touch_report_t report = {
         .pressed = false,
     };
 
-    const bool pressed = is_ili9341_pressed();
-    if (pressed) {
-        const touch_report_t now = get_spi_touch_report(ili9341_touch, false);
-
-        // FIXME: do not hardcode 0
-        const screen_pressed_msg_t msg = make_screen_pressed(0, now);
-
-        if (IS_ENABLED(XAP)) {
-            xap_broadcast_user(&msg, sizeof(msg));
-        }
+    if (is_ili9341_pressed()) {
+        report = get_spi_touch_report(ili9341_touch, false);
+    }
 
-        if (IS_ENABLED(M5)) {
-            m5_send(&msg, sizeof(msg));
-        }
+    touch_report_t              point;
+    const touch_filter_result_t result = touch_filter_apply(&touch_filter, report, &point);
 
-        last = now;
-    } else {
-        // notify about release, if XAP is enabled
-        if (last.pressed) {
-            // FIXME: do not hardcode 0
-            const screen_released_msg_t msg = make_screen_released(0);
+    if (result & TOUCH_FILTER_POINT) {
+        // FIXME: do not hardcode 0
+        const screen_pressed_msg_t msg = make_screen_pressed(0, point);
+        send_touch_event(&msg, sizeof(msg));
+    }
 
-            if (IS_ENABLED(XAP)) {
-                xap_broadcast_user(&msg, sizeof(msg));
-            }
+    if (result & TOUCH_FILTER_RELEASE) {
+        // FIXME: do not hardcode 0
+        const screen_released_msg_t msg = make_screen_released(0);
+        send_touch_event(&msg, sizeof(msg));
+    }
 
-            if (IS_ENABLED(M5)) {
-                m5_send(&msg, sizeof(msg));
-            }
-        }
+    return 100;
+}
 
-        last.pressed = false;
+// FNV-1a
+static uint32_t hash_str(uint32_t hash, const char *str) {
+    for (; *str != '\0'; ++str) {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619;
     }
 
-    return 100;
+    return hash;
 }
 
-static void render_autoconf(void) {
-    painter_font_handle_t font = qp_load_font_mem(font_ubuntu);
+// draws settings on the e-ink screen (unless `draw` is false), returns a hash of the text (0 on error)
+static uint32_t render_autoconf(bool draw) {
+    uint32_t hash = 2166136261;
+
+    painter_font_handle_t font = acquire_font(font_ubuntu);
     if (font == NULL) {
         logging(LOG_ERROR, "%s: font == NULL", __func__);
-        return;
+        return 0;
     }
 
     struct {
@@ -186,7 +232,12 @@ static void render_autoconf(void) {
                 break;
         }
 
-        qp_drawtext_recolor(il91874, pos.x, pos.y, font, str.ptr, HSV_BLACK, HSV_WHITE);
+        if (draw) {
+            qp_drawtext_recolor(il91874, pos.x, pos.y, font, str.ptr, HSV_BLACK, HSV_WHITE);
+        }
+
+        hash = hash_str(hash, str.ptr);
+        hash = hash_str(hash, "\n");
         str_reset(&str);
 
         pos.y += font->line_height;
@@ -204,8 +255,28 @@ static void render_autoconf(void) {
         }
     }
 
-    qp_close_font(font);
+    release_font(font);
+
+    return hash;
+}
+
+#if IS_ENABLED(QP_EINK_DIFF)
+// hash of the contents drawn on boot, stored once they have been flushed
+static uint32_t pending_hash = 0;
+
+void qp_eink_diff_flushed(painter_device_t device) {
+    if (device != il91874 || pending_hash == 0) {
+        return;
+    }
+
+    user_data_t eeprom = {
+        .autoconf_hash = pending_hash,
+    };
+    eeconfig_update_user_datablock_field(eeprom, autoconf_hash);
+
+    pending_hash = 0;
 }
+#endif
 
 #if CM_ENABLED(LEDMAP)
 // hack layout macro, so that un-used spots are filled with NONE rather than KC_NO
@@ -276,6 +347,32 @@ const char *log_time(void) {
     return buff;
 }
 
+#if IS_ENABLED(QP_FRAMEBUFFER)
+// draw on a framebuffer for `display`, if there's memory for it
+static painter_device_t buffered(qp_framebuffer_t *framebuffer, painter_device_t display, uint16_t width, uint16_t height, size_t size, uint8_t *dirty) {
+    void *buffer = malloc(size);
+    if (buffer == NULL) {
+        logging(LOG_WARN, "%s: could not allocate %d bytes", __func__, (int)size);
+        return display;
+    }
+
+    // schedule first: once the surface works, it keeps pointing at `buffer`, nothing may fail (and free it) after that
+    if (!qp_framebuffer_schedule(framebuffer)) {
+        free(buffer);
+        return display;
+    }
+
+    const painter_device_t surface = qp_framebuffer_init(framebuffer, display, width, height, buffer, dirty);
+    if (surface == NULL) {
+        qp_framebuffer_unschedule(framebuffer);
+        free(buffer);
+        return display;
+    }
+
+    return surface;
+}
+#endif
+
 //
 // QMK hooks
 //
@@ -284,39 +381,51 @@ void keyboard_post_init_keymap(void) {
     if (IS_ENABLED(QUANTUM_PAINTER) && is_keyboard_left()) {
         set_device_by_name("il91874", il91874);
 
-        u128       running_build_id;
-        const bool err = get_build_id(&running_build_id) < 0;
-
         user_data_t eeprom = {0};
-        eeconfig_read_user_datablock_field(eeprom, build_id);
-
-        const bool new_fw = !err && memcmp(&running_build_id, &eeprom.build_id, sizeof(u128)) != 0;
-        // NOTE: sub-optimal because screen won't be drawn immediately
-        //       it is flushed 3 minutes after boot, to prevent damaging it
-        //       this means that losing power during that time will cause no redraw but storing new id
-        //       which in turn means next power cycle won't draw as eeprom value matches
-        if (new_fw) {
-            eeprom.build_id = running_build_id;
-            eeconfig_update_user_datablock_field(eeprom, build_id);
+        eeconfig_read_user_datablock_field(eeprom, autoconf_hash);
+
+#if IS_ENABLED(QP_EINK_DIFF)
+        // contents are always drawn on the buffer, so that it matches the panel
+        const uint32_t hash = render_autoconf(true);
+
+        // panel is only refreshed when the contents changed, hash gets stored after that happens
+        // thus, losing power before the (delayed) flush just causes another redraw on next boot
+        if (hash != 0 && hash == eeprom.autoconf_hash) {
+            qp_eink_diff_mark_synced(il91874);
+        } else {
+            pending_hash = hash;
         }
-
-        // FIXME: AUTOCONF_FW_CHECK is a hack to fix screen getting wiped (removes text)
-        //        find out the root cause of that, and remove this workaround
-        const bool skip_draw = IS_DEFINED(AUTOCONF_FW_CHECK) && new_fw;
-        // only draw when a new firmware is flashed
-        // this may still be a "useless" redraw (no settings changed)
-        // but is already much better than drawing on every power cycle
-        if (!skip_draw) {
-            render_autoconf();
+#else
+        // without diffing, drawing means a full refresh, only do it when contents changed
+        // hash is stored right away, losing power before the (delayed) flush leaves the panel outdated
+        const uint32_t hash = render_autoconf(false);
+        if (hash != 0 && hash != eeprom.autoconf_hash) {
+            render_autoconf(true);
+
+            eeprom.autoconf_hash = hash;
+            eeconfig_update_user_datablock_field(eeprom, autoconf_hash);
         }
+#endif
     }
 
     if (IS_ENABLED(QUANTUM_PAINTER) && !is_keyboard_left()) {
-        set_device_by_name("ili9163", ili9163);
         set_device_by_name("ili9341", ili9341);
 
+        painter_device_t ili9163_display = ili9163;
+#if IS_ENABLED(QP_FRAMEBUFFER)
+        ili9163_display = buffered(&ili9163_framebuffer, ili9163, ILI9163_WIDTH, ILI9163_HEIGHT, ILI9163_BUFFER_SIZE, ili9163_dirty);
+#endif
+        set_device_by_name("ili9163", ili9163_display);
+
 #if CM_ENABLED(UI)
-        ui_init(&root, qp_get_width(ili9341), qp_get_height(ili9341));
+        ui_display = ili9341;
+
+#    if IS_ENABLED(QP_FRAMEBUFFER)
+        // draw offscreen, only flushing regions that changed
+        ui_display = buffered(&ui_framebuffer, ili9341, ILI9341_WIDTH, ILI9341_HEIGHT, ILI9341_BUFFER_SIZE, ui_dirty);
+#    endif
+
+        ui_init(&root, qp_get_width(ui_display), qp_get_height(ui_display));
 #endif
     }
 
@@ -344,7 +453,12 @@ void housekeeping_task_keymap(void) {
     }
 
 #if CM_ENABLED(UI)
-    ui_render(&root, ili9341);
+    ui_render(&root, ui_display);
+#endif
+
+#if IS_ENABLED(QP_FRAMEBUFFER)
+    // displays share the bus, flush them in turns so that none of them (nor touch reads) gets starved
+    qp_framebuffer_task();
 #endif
 }
 
@@ -16,6 +16,14 @@
 #    include "elpekenin/logging/backends/qp.h"
 #endif
 
+#if IS_ENABLED(QP_PROFILER)
+#    include "elpekenin/qp/profiler.h"
+#else
+// compat: render functions used as-is
+#    define QP_PROFILED(render) render
+#    define QP_PROFILER_WRAP(render)
+#endif
+
 STATIC_ASSERT(CM_ENABLED(BUILD_ID), "Must enable 'elpekenin/build_id'");
 #include "elpekenin/build_id.h"
 
@@ -29,6 +37,37 @@ STATIC_ASSERT(CM_ENABLED(BUILD_ID), "Must enable 'elpekenin/build_id'");
 #include "elpekenin/qp/ui/computer.h"
 #include "elpekenin/qp/ui/github.h"
 
+// report which node is being drawn, to account the traffic it generates
+QP_PROFILER_WRAP(build_id_render)
+QP_PROFILER_WRAP(build_match_render)
+QP_PROFILER_WRAP(github_render)
+QP_PROFILER_WRAP(uptime_render)
+QP_PROFILER_WRAP(layer_render)
+QP_PROFILER_WRAP(computer_render)
+QP_PROFILER_WRAP(text_render)
+QP_PROFILER_WRAP(rgb_mode_render)
+QP_PROFILER_WRAP(rgb_hsv_render)
+
+#if CM_ENABLED(MEMORY)
+QP_PROFILER_WRAP(flash_render)
+#endif
+
+#if CM_ENABLED(ALLOCATOR)
+QP_PROFILER_WRAP(heap_render)
+#endif
+
+#if CM_ENABLED(KEYLOG)
+QP_PROFILER_WRAP(keylog_render)
+#endif
+
+#if IS_ENABLED(QP_LOG)
+QP_PROFILER_WRAP(qp_logging_render)
+#endif
+
+#if IS_ENABLED(QP_PROFILER)
+QP_PROFILER_WRAP(qp_profiler_render)
+#endif
+
 // clang really wants to indent things far to the right...
 
 // clang-format off
@@ -52,13 +91,13 @@ static ui_node_t id[] = {
     {
         .node_size = UI_FONT(1),
         .init      = build_id_init,
-        .render    = build_id_render,
+        .render    = QP_PROFILED(build_id_render),
         .args      = &build_id_args,
     },
     {
         .node_size = UI_FONT(1),
         .init      = build_match_init,
-        .render    = build_match_render,
+        .render    = QP_PROFILED(build_match_render),
         .args      = &build_match_args,
     },
 };
@@ -67,7 +106,7 @@ static ui_node_t first_row[] = {
     {
         .node_size = UI_IMAGE(1),
         .init      = github_init,
-        .render    = github_render,
+        .render    = QP_PROFILED(github_render),
         .args      = &gh_args,
     },
 #if CM_ENABLED(BUILD_ID)
@@ -118,20 +157,20 @@ static ui_node_t left[] = {
     {
         .node_size = UI_FONT(1),
         .init      = uptime_init,
-        .render    = uptime_render,
+        .render    = QP_PROFILED(uptime_render),
         .args      = &uptime_args,
     },
     {
         .node_size = UI_FONT(1),
         .init      = layer_init,
-        .render    = layer_render,
+        .render    = QP_PROFILED(layer_render),
         .args      = &layer_args,
     },
 #if CM_ENABLED(MEMORY)
     {
         .node_size = UI_FONT(1),
         .init      = flash_init,
-        .render    = flash_render,
+        .render    = QP_PROFILED(flash_render),
         .args      = &flash_args,
     },
 #endif
@@ -140,7 +179,7 @@ static ui_node_t left[] = {
     {
         .node_size = UI_FONT(1),
         .init      = heap_init,
-        .render    = heap_render,
+        .render    = QP_PROFILED(heap_render),
         .args      = &heap_args,
     },
 #endif
@@ -148,7 +187,7 @@ static ui_node_t left[] = {
     {
         .node_size = UI_REMAINING(),
         .init      = computer_init,
-        .render    = computer_render,
+        .render    = QP_PROFILED(computer_render),
         .args      = &computer_args,
     }
 };
@@ -177,13 +216,13 @@ static ui_node_t rgb_mode[] = {
     {
         .node_size = UI_RELATIVE(20),
         .init      = text_init,
-        .render    = text_render,
+        .render    = QP_PROFILED(text_render),
         .args      = &rgb_mode_args,
     },
     {
         .node_size = UI_REMAINING(),
         .init      = rgb_init,
-        .render    = rgb_mode_render,
+        .render    = QP_PROFILED(rgb_mode_render),
         .args      = &rgb_args,
     },
 };
@@ -192,13 +231,13 @@ static ui_node_t rgb_hsv[] = {
     {
         .node_size = UI_RELATIVE(20),
         .init      = text_init,
-        .render    = text_render,
+        .render    = QP_PROFILED(text_render),
         .args      = &rgb_hsv_args,
     },
     {
         .node_size = UI_REMAINING(),
         .init      = rgb_init,
-        .render    = rgb_hsv_render,
+        .render    = QP_PROFILED(rgb_hsv_render),
         .args      = &rgb_args,
     },
 };
@@ -228,6 +267,12 @@ static qp_logging_args_t qp_logging_args = {
 };
 #endif
 
+#if IS_ENABLED(QP_PROFILER)
+static qp_profiler_args_t qp_profiler_args = {
+    .font = font_fira_code,
+};
+#endif
+
 static ui_node_t right[] = {
 #if IS_ENABLED(RGB_MATRIX)
     {
@@ -242,16 +287,25 @@ static ui_node_t right[] = {
     {
         .node_size = UI_FONT(1),
         .init      = keylog_init,
-        .render    = keylog_render,
+        .render    = QP_PROFILED(keylog_render),
         .args      = &keylog_args,
     },
 #endif
 
+#if IS_ENABLED(QP_PROFILER)
+    {
+        .node_size = UI_FONT(QUANTUM_PAINTER_NUM_DISPLAYS),
+        .init      = qp_profiler_init,
+        .render    = QP_PROFILED(qp_profiler_render),
+        .args      = &qp_profiler_args,
+    },
+#endif
+
 #if IS_ENABLED(QP_LOG)
     {
         .node_size = UI_REMAINING(),
         .init      = qp_logging_init,
-        .render    = qp_logging_render,
+        .render    = QP_PROFILED(qp_logging_render),
         .args      = &qp_logging_args,
     },
 #endif
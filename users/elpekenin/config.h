@@ -56,5 +56,7 @@
     RPC_ID_USER_LOGGING, \
     RPC_ID_USER_EEPROM_CLEAR, \
     RPC_ID_USER_XAP, \
-    RPC_ID_USER_BUILD_ID
+    RPC_ID_USER_XAP_RESULTS, \
+    RPC_ID_USER_BUILD_ID, \
+    RPC_ID_USER_DEVICE_INDEX
 // clang-format on
@@ -46,18 +46,39 @@
 #define XAP_ENABLE 1
 #define SIPO_PINS_ENABLE 1
 #define N_SIPO_PINS 8
+#define UART_TX_BUFFER_SIZE 512
+#define LOG_LINE_SIZE 80
+#define LOG_LINE_FLUSH_DELAY 50
 #define QP_LOG_ENABLE 1
 #define QP_LOG_N_CHARS 70
 #define QP_LOG_N_LINES 13
 #define QP_LOGGING_UI_REDRAW_INTERVAL 100
+#define QP_LOG_UI_WRAP 1
 #define QP_ASSETS_SIZE 30
+#define QP_FRAMEBUFFER_ENABLE 1
+#define QP_FRAMEBUFFER_TILE_SIZE 16
+#define QP_FRAMEBUFFER_SLICE_SIZE 4096
+#define QP_FRAMEBUFFER_FRAME_BUDGET 16384
+#define QP_EINK_DIFF_ENABLE 1
+#define QP_EINK_FULL_REFRESH_INTERVAL 10
+#define QP_EINK_MIN_REFRESH_INTERVAL 5000
+#define QP_PROFILER_ENABLE 1
+#define QP_PROFILER_NODES 16
+#define QP_PROFILER_UI_REDRAW_INTERVAL 1000
+#define QP_DISPLAY_LIST_ENABLE 1
+#define QP_DISPLAY_LIST_SIZE 512
+#define QP_STREAM_ENABLE 1
+#define QP_STREAM_PALETTE_SIZE 256
 #define COMPUTER_STATS_SIZE 30
+#define COMPUTER_STATS_DECIMATION 1
 #define COMPUTER_STATS_UI_REDRAW_INTERVAL 500
 #define COMPUTER_STATS_UI_TIMEOUT 5000
 #define BUILD_MATCH_UI_REDRAW_INTERVAL 500
 #define GITHUB_NOTIFICATIONS_UI_REDRAW_INTERVAL 500
 #define GITHUB_NOTIFICATIONS_UI_TIMEOUT 5000
 #define TOUCH_SCREEN_ENABLE 1
+#define TOUCH_FILTER_MIN_DISTANCE 3
+#define TOUCH_FILTER_MIN_INTERVAL 200
 #define M5_ENABLE 1
 #define M5_DEBUG 1
 #define M5_BAUD_RATE 115200
@@ -102,18 +123,39 @@
     X(XAP_ENABLE) \
     X(SIPO_PINS_ENABLE) \
     X(N_SIPO_PINS) \
+    X(UART_TX_BUFFER_SIZE) \
+    X(LOG_LINE_SIZE) \
+    X(LOG_LINE_FLUSH_DELAY) \
     X(QP_LOG_ENABLE) \
     X(QP_LOG_N_CHARS) \
     X(QP_LOG_N_LINES) \
     X(QP_LOGGING_UI_REDRAW_INTERVAL) \
+    X(QP_LOG_UI_WRAP) \
     X(QP_ASSETS_SIZE) \
+    X(QP_FRAMEBUFFER_ENABLE) \
+    X(QP_FRAMEBUFFER_TILE_SIZE) \
+    X(QP_FRAMEBUFFER_SLICE_SIZE) \
+    X(QP_FRAMEBUFFER_FRAME_BUDGET) \
+    X(QP_EINK_DIFF_ENABLE) \
+    X(QP_EINK_FULL_REFRESH_INTERVAL) \
+    X(QP_EINK_MIN_REFRESH_INTERVAL) \
+    X(QP_PROFILER_ENABLE) \
+    X(QP_PROFILER_NODES) \
+    X(QP_PROFILER_UI_REDRAW_INTERVAL) \
+    X(QP_DISPLAY_LIST_ENABLE) \
+    X(QP_DISPLAY_LIST_SIZE) \
+    X(QP_STREAM_ENABLE) \
+    X(QP_STREAM_PALETTE_SIZE) \
     X(COMPUTER_STATS_SIZE) \
+    X(COMPUTER_STATS_DECIMATION) \
     X(COMPUTER_STATS_UI_REDRAW_INTERVAL) \
     X(COMPUTER_STATS_UI_TIMEOUT) \
     X(BUILD_MATCH_UI_REDRAW_INTERVAL) \
     X(GITHUB_NOTIFICATIONS_UI_REDRAW_INTERVAL) \
     X(GITHUB_NOTIFICATIONS_UI_TIMEOUT) \
     X(TOUCH_SCREEN_ENABLE) \
+    X(TOUCH_FILTER_MIN_DISTANCE) \
+    X(TOUCH_FILTER_MIN_INTERVAL) \
     X(M5_ENABLE) \
     X(M5_DEBUG) \
     X(M5_BAUD_RATE)
@@ -3,9 +3,9 @@
 
 #pragma once
 
-#include "elpekenin/build_id.h"
+#include <quantum/quantum.h>
 
 typedef struct PACKED {
-    u128 build_id;
+    uint32_t autoconf_hash;
 } user_data_t;
 STATIC_ASSERT(sizeof(user_data_t) <= EECONFIG_USER_DATA_SIZE, "Data won't fit");
@@ -3,4 +3,26 @@
 
 #pragma once
 
+#include <quantum/compiler_support.h>
+#include <stddef.h>
+#include <stdint.h>
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+#ifndef LOG_LINE_SIZE
+#    define LOG_LINE_SIZE 80
+#endif
+
+#ifndef LOG_LINE_FLUSH_DELAY
+#    define LOG_LINE_FLUSH_DELAY 50
+#endif
+
+// backends get whole lines (or, if they are too long, chunks of LOG_LINE_SIZE chars)
+// unfinished lines are also handed over after LOG_LINE_FLUSH_DELAY ms without a newline
+typedef int8_t (*write_func_t)(const char *data, size_t length);
+
 void sendchar_init(void);
+
+// level of the message that started the line being handed to backends
+log_level_t logging_line_level(void);
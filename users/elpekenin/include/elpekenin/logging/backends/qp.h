@@ -3,12 +3,14 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 //
-// sendchar
+// backend
 //
 void   sendchar_qp_init(void);
+int8_t write_qp(const char *data, size_t length);
 int8_t sendchar_qp(uint8_t chr);
 
 //
@@ -24,7 +26,6 @@ void qp_log_clear(void);
 
 typedef struct {
     const uint8_t *font;
-    ui_time_t      last_draw;
 } qp_logging_args_t;
 STATIC_ASSERT(offsetof(qp_logging_args_t, font) == 0, "UI will crash :)");
 
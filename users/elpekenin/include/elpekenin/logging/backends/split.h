@@ -3,8 +3,10 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+int8_t write_split(const char* data, size_t length);
 int8_t sendchar_split(uint8_t chr);
 
 uint32_t user_logging_master_poll(void);
@@ -3,8 +3,10 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 void sendchar_uart_init(void);
 
+int8_t write_uart(const char *data, size_t length);
 int8_t sendchar_uart(uint8_t chr);
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+int8_t write_xap(const char *data, size_t length);
 int8_t sendchar_xap(uint8_t chr);
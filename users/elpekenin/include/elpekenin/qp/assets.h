@@ -7,30 +7,75 @@
 
 //
 
+typedef struct {
+    uint32_t    hash;
+    const char *name;
+    const void *data; // QFF/QGF contents
+} qp_asset_slot_t;
+
+// perfect hash table (hash and displace), generated by `qp_resources` into flash
+typedef struct {
+    size_t                 buckets;
+    const uint16_t        *seeds; // seed of each bucket, for the hash that gives the slot
+    size_t                 size;
+    const qp_asset_slot_t *slots;
+    size_t                 count;
+    const uint16_t        *order; // slot of each asset, sorted by name
+} qp_asset_table_t;
+
+uint32_t qp_asset_hash(uint32_t seed, const char *name);
+
+//
+
+// handles are refcounted and kept open after their last release, until room is needed for other assets
+painter_font_handle_t acquire_font(const void *data);
+
+void release_font(painter_font_handle_t font);
+
+// keep an (acquired) handle open for good, for users that don't have an end, it must still be released
+void pin_font(painter_font_handle_t font);
+
+painter_image_handle_t acquire_image(const void *data);
+
+void release_image(painter_image_handle_t image);
+
+void pin_image(painter_image_handle_t image);
+
+//
+
 void set_device_by_name(const char *name, painter_device_t device);
 
 painter_device_t get_device_by_name(const char *name);
 
+// position of the asset, to be used with get_*_by_index
+bool get_device_index(const char *name, size_t *index);
+
 size_t get_num_devices(void);
 
 painter_device_t get_device_by_index(size_t index);
 
-//
+// name it was registered with, NULL if out of range
+const char *get_device_name(size_t index);
 
-void set_font_by_name(const char *name, const uint8_t *font);
+//
 
+// NOTE: font/image getters acquire the handle, release it when done
 painter_font_handle_t get_font_by_name(const char *name);
 
+bool get_font_index(const char *name, size_t *index);
+
+// same as `QP_NUM_FONTS`, for code that can't include the generated header
 size_t get_num_fonts(void);
 
 painter_font_handle_t get_font_by_index(size_t index);
 
 //
 
-void set_image_by_name(const char *name, const uint8_t *image);
-
 painter_image_handle_t get_image_by_name(const char *name);
 
+bool get_image_index(const char *name, size_t *index);
+
+// same as `QP_NUM_IMAGES`, for code that can't include the generated header
 size_t get_num_images(void);
 
 painter_image_handle_t get_image_by_index(size_t index);
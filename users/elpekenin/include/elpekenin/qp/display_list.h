@@ -0,0 +1,124 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Batches of QP drawing commands, encoded in a compact binary format.
+ *
+ * Instead of sending each primitive on its own (with the round-trip it implies), a host can build a list of them,
+ * send it in chunks with :c:func:`qp_display_list_append` and run all of them at once with
+ * :c:func:`qp_display_list_execute`.
+ *
+ * Each command is an opcode (:c:enum:`qp_display_list_op_t`) followed by its arguments. Devices, fonts and images are
+ * referred to by their index on the assets registry, instead of by name. Multi-byte values are little endian.
+ *
+ * .. caution::
+ *   Indices refer to devices on this half only.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/painter/qp.h>
+
+#ifndef QP_DISPLAY_LIST_SIZE
+#    define QP_DISPLAY_LIST_SIZE 512
+#endif
+
+/**
+ * Available commands, along with their arguments.
+ */
+typedef enum {
+    /**
+     * ``u8 device``
+     */
+    QP_DL_CLEAR,
+
+    /**
+     * ``u8 device, u16 x, u16 y, u8 hue, u8 sat, u8 val``
+     */
+    QP_DL_SETPIXEL,
+
+    /**
+     * ``u8 device, u16 x0, u16 y0, u16 x1, u16 y1, u8 hue, u8 sat, u8 val``
+     */
+    QP_DL_LINE,
+
+    /**
+     * ``u8 device, u16 left, u16 top, u16 right, u16 bottom, u8 hue, u8 sat, u8 val, u8 filled``
+     */
+    QP_DL_RECT,
+
+    /**
+     * ``u8 device, u16 x, u16 y, u16 radius, u8 hue, u8 sat, u8 val, u8 filled``
+     */
+    QP_DL_CIRCLE,
+
+    /**
+     * ``u8 device, u16 x, u16 y, u16 sizex, u16 sizey, u8 hue, u8 sat, u8 val, u8 filled``
+     */
+    QP_DL_ELLIPSE,
+
+    /**
+     * ``u8 device, u8 image, u16 x, u16 y``
+     */
+    QP_DL_DRAWIMAGE,
+
+    /**
+     * ``u8 device, u8 image, u16 x, u16 y, u8 hue_fg, u8 sat_fg, u8 val_fg, u8 hue_bg, u8 sat_bg, u8 val_bg``
+     */
+    QP_DL_DRAWIMAGE_RECOLOR,
+
+    /**
+     * ``u8 device, u8 font, u16 x, u16 y, u8 length, char text[length]``
+     */
+    QP_DL_DRAWTEXT,
+
+    /**
+     * ``u8 device, u8 font, u16 x, u16 y, u8 hue_fg, u8 sat_fg, u8 val_fg, u8 hue_bg, u8 sat_bg, u8 val_bg, u8 length, char text[length]``
+     */
+    QP_DL_DRAWTEXT_RECOLOR,
+
+    /**
+     * ``u8 device, u16 left, u16 top, u16 right, u16 bottom``
+     */
+    QP_DL_VIEWPORT,
+
+    /**
+     * ``u8 device, u8 n_pixels, u16 pixels[n_pixels]`` (RGB565)
+     */
+    QP_DL_PIXDATA,
+
+    /**
+     * ``u8 device``
+     */
+    QP_DL_FLUSH,
+} qp_display_list_op_t;
+
+/**
+ * Discard the contents of the list.
+ */
+void qp_display_list_reset(void);
+
+/**
+ * Add a chunk of data at the end of the list.
+ *
+ * .. hint::
+ *   Commands may be split across chunks, only the complete list gets parsed.
+ *
+ * Return:
+ *     Whether there was room for it. If there wasn't, the list is discarded.
+ */
+bool qp_display_list_append(const uint8_t *data, size_t length);
+
+/**
+ * Run the commands on the list, and empty it.
+ *
+ * Args:
+ *     flush: Whether to flush every device that was drawn on, after the last command.
+ *     executed: Where to write the number of commands that ran.
+ *
+ * Return:
+ *     Whether all of them could be run. Execution stops at the first invalid (or truncated) command.
+ */
+bool qp_display_list_execute(bool flush, uint16_t *executed);
@@ -0,0 +1,128 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Partial refreshes for IL91874 e-ink panels.
+ *
+ * A copy of the last flushed buffer is kept around, when flushing again it gets compared with the current contents.
+ * If only the black plane changed, the bounding box of the differences is sent and refreshed with the partial
+ * update commands, instead of redrawing the whole panel (which takes a few seconds).
+ *
+ * Nothing is sent if nothing changed. Every ``QP_EINK_FULL_REFRESH_INTERVAL`` partial refreshes, a full one is
+ * performed instead, to get rid of ghosting.
+ *
+ * The panel's busy line is not wired, so it is assumed to be busy for ``QP_EINK_MIN_REFRESH_INTERVAL`` milliseconds
+ * after any refresh, flushes are refused until then. Partial refreshes also honour the driver's own cooldown.
+ *
+ * .. caution::
+ *   Buffer is expected to be laid out as the eink_panel driver does: black plane followed by red plane, both
+ *   1bpp and in the panel's native orientation.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/painter/qp.h>
+#include <quantum/painter/qp_internal.h>
+
+#ifndef QP_EINK_FULL_REFRESH_INTERVAL
+#    define QP_EINK_FULL_REFRESH_INTERVAL 10
+#endif
+
+#ifndef QP_EINK_MIN_REFRESH_INTERVAL
+#    define QP_EINK_MIN_REFRESH_INTERVAL 5000
+#endif
+
+/**
+ * State of the diffing.
+ *
+ * .. caution::
+ *   Members are not meant to be used directly.
+ */
+typedef struct {
+    /**
+     * Driver's buffer, where QP draws.
+     */
+    const uint8_t *buffer;
+
+    /**
+     * Contents of the panel, as of last flush.
+     */
+    uint8_t *previous;
+
+    /**
+     * Native horizontal size.
+     */
+    uint16_t width;
+
+    /**
+     * Native vertical size.
+     */
+    uint16_t height;
+
+    /**
+     * Whether ``previous`` matches the panel's contents.
+     */
+    bool synced;
+
+    /**
+     * Partial refreshes since last full one.
+     */
+    uint8_t partials;
+
+    /**
+     * Whether a refresh was sent since boot.
+     */
+    bool refreshed;
+
+    /**
+     * When last refresh was sent.
+     */
+    uint32_t last_refresh;
+
+    /**
+     * Driver's original vtable, whose flush is wrapped.
+     */
+    const painter_driver_vtable_t *inner;
+
+    /**
+     * Vtable used by the device, after wrapping.
+     */
+    painter_driver_vtable_t vtable;
+} qp_eink_diff_t;
+
+/**
+ * Hook into a device's flush, to perform partial refreshes when possible.
+ *
+ * Args:
+ *     eink: State to be initialized.
+ *     device: E-ink display.
+ *     width: Native horizontal size.
+ *     height: Native vertical size.
+ *     buffer: The one given to the driver.
+ *     previous: Storage for the last flushed contents, same size as ``buffer``.
+ *
+ * Return:
+ *     Whether operation was successful.
+ */
+bool qp_eink_diff_init(qp_eink_diff_t *eink, painter_device_t device, uint16_t width, uint16_t height, const void *buffer, void *previous);
+
+/**
+ * Flag the current buffer as being what the panel already shows, so that flushing it is a no-op.
+ *
+ * .. hint::
+ *   Useful after re-drawing (on boot) the contents that were on the screen before power was lost.
+ *
+ * Return:
+ *     Whether operation was successful, ie: ``device`` was set up with :c:func:`qp_eink_diff_init`.
+ */
+bool qp_eink_diff_mark_synced(painter_device_t device);
+
+/**
+ * Hook called after ``device`` got flushed successfully (either fully or partially).
+ *
+ * .. hint::
+ *   Weak symbol, override it to find out when the panel's contents are up to date.
+ */
+void qp_eink_diff_flushed(painter_device_t device);
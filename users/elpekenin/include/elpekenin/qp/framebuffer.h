@@ -0,0 +1,187 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Offscreen (RGB565) framebuffer that keeps track of the regions that changed, to only send those to a display.
+ *
+ * Drawing functions operate on a QP surface, and pixels are compared with the buffer's contents as they
+ * are written. Areas where something changed are flagged as dirty (on a grid of square tiles), and
+ * :c:func:`qp_framebuffer_flush` merges adjacent dirty tiles into rectangles that get sent to the display.
+ *
+ * This way, re-drawing a region with the same content (eg: clearing and re-drawing some text) is free.
+ *
+ * Displays sharing a bus can be flushed with :c:func:`qp_framebuffer_task`, which sends bounded slices of each
+ * framebuffer in turns. A big update is then spread across several loops, instead of blocking everything else.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/painter/qp.h>
+#include <quantum/painter/qp_internal.h>
+
+#ifndef QP_FRAMEBUFFER_TILE_SIZE
+#    define QP_FRAMEBUFFER_TILE_SIZE 16
+#endif
+
+#ifndef QP_FRAMEBUFFER_SLICE_SIZE
+#    define QP_FRAMEBUFFER_SLICE_SIZE 4096
+#endif
+
+#ifndef QP_FRAMEBUFFER_FRAME_BUDGET
+#    define QP_FRAMEBUFFER_FRAME_BUDGET 16384
+#endif
+
+/**
+ * Number of tiles needed to cover ``size`` pixels.
+ */
+#define QP_FRAMEBUFFER_TILES(size) (((size) + QP_FRAMEBUFFER_TILE_SIZE - 1) / QP_FRAMEBUFFER_TILE_SIZE)
+
+/**
+ * Size of the array (in bytes) needed to track dirty tiles of a ``width`` x ``height`` framebuffer.
+ */
+#define QP_FRAMEBUFFER_DIRTY_BYTES(width, height) ((QP_FRAMEBUFFER_TILES(width) * QP_FRAMEBUFFER_TILES(height) + 7) / 8)
+
+/**
+ * State of a framebuffer.
+ *
+ * .. caution::
+ *   Members are not meant to be used directly.
+ */
+typedef struct {
+    /**
+     * Display where contents get flushed to.
+     */
+    painter_device_t target;
+
+    /**
+     * Surface where drawing happens.
+     */
+    painter_device_t surface;
+
+    /**
+     * Pixels in the surface.
+     */
+    uint16_t *buffer;
+
+    /**
+     * Bitmap of tiles that changed since last flush.
+     */
+    uint8_t *dirty;
+
+    /**
+     * Horizontal size.
+     */
+    uint16_t width;
+
+    /**
+     * Vertical size.
+     */
+    uint16_t height;
+
+    /**
+     * Surface's original vtable, whose functions are wrapped.
+     */
+    const painter_driver_vtable_t *inner;
+
+    /**
+     * Vtable used by the surface, after wrapping.
+     */
+    painter_driver_vtable_t vtable;
+
+    /**
+     * Position where the next pixel will be written.
+     */
+    struct {
+        uint16_t left;
+        uint16_t top;
+        uint16_t right;
+        uint16_t bottom;
+        uint16_t x;
+        uint16_t y;
+    } cursor;
+
+    /**
+     * Region being flushed, ``row`` is the next one to be sent.
+     */
+    struct {
+        bool     active;
+        uint16_t left;
+        uint16_t right;
+        uint16_t row;
+        uint16_t bottom;
+    } pending;
+} qp_framebuffer_t;
+
+/**
+ * Set up a framebuffer.
+ *
+ * Args:
+ *     framebuffer: State to be initialized.
+ *     target: Display to which contents will be flushed.
+ *     width: Horizontal size.
+ *     height: Vertical size.
+ *     buffer: Storage for pixels, at least ``SURFACE_REQUIRED_BUFFER_BYTE_SIZE(width, height, 16)`` bytes.
+ *     dirty: Storage for dirty tracking, at least ``QP_FRAMEBUFFER_DIRTY_BYTES(width, height)`` bytes.
+ *
+ * Return:
+ *     Device to be drawn on, ``NULL`` if something went wrong.
+ */
+painter_device_t qp_framebuffer_init(qp_framebuffer_t *framebuffer, painter_device_t target, uint16_t width, uint16_t height, void *buffer, uint8_t *dirty);
+
+/**
+ * Get the display behind a device.
+ *
+ * .. hint::
+ *   Operations on the panel itself (eg: power, geometry) must not be performed on the surface.
+ *
+ * Return:
+ *     ``target`` of the framebuffer if ``device`` is its surface, ``device`` otherwise.
+ */
+painter_device_t qp_framebuffer_target(painter_device_t device);
+
+/**
+ * Send the regions that changed since last call to the display.
+ *
+ * Return:
+ *     Whether operation was successful.
+ */
+bool qp_framebuffer_flush(qp_framebuffer_t *framebuffer);
+
+/**
+ * Whether there are changes yet to be sent.
+ */
+bool qp_framebuffer_is_dirty(const qp_framebuffer_t *framebuffer);
+
+/**
+ * Send changes to the display, stopping after ``max_pixels``.
+ *
+ * .. hint::
+ *   Data is sent in full rows, at least one. Thus, the limit may be exceeded on wide regions.
+ *
+ * Return:
+ *     Amount of pixels sent.
+ */
+uint32_t qp_framebuffer_flush_slice(qp_framebuffer_t *framebuffer, uint32_t max_pixels);
+
+/**
+ * Add a framebuffer to the ones flushed by :c:func:`qp_framebuffer_task`.
+ *
+ * Return:
+ *     Whether it could be added.
+ */
+bool qp_framebuffer_schedule(qp_framebuffer_t *framebuffer);
+
+/**
+ * Remove a framebuffer from the ones flushed by :c:func:`qp_framebuffer_task`, no-op if it was not there.
+ */
+void qp_framebuffer_unschedule(qp_framebuffer_t *framebuffer);
+
+/**
+ * Flush scheduled framebuffers, sending up to ``QP_FRAMEBUFFER_FRAME_BUDGET`` pixels in total.
+ *
+ * Framebuffers take turns to send (at most) ``QP_FRAMEBUFFER_SLICE_SIZE`` pixels, next call resumes where this
+ * one stopped. Thus, a display is never more than a slice behind another one.
+ */
+void qp_framebuffer_task(void);
@@ -0,0 +1,156 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Line graphs that are drawn incrementally.
+ *
+ * Instead of clearing the area and drawing every segment whenever a value arrives, the graph sweeps horizontally (like
+ * an oscilloscope): each update only draws the newest column, and erases the one after it, which acts as a cursor
+ * between new and old data. Thus, the cost of an update does not depend on how long the history is.
+ *
+ * Several samples can be merged into a single column (see ``samples_per_column``), keeping their minimum and maximum
+ * so that spikes are still visible.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/color.h>
+#include <quantum/painter/qp.h>
+
+/**
+ * Summary of the samples in a column.
+ */
+typedef struct {
+    /**
+     * Lowest value.
+     */
+    uint8_t min;
+
+    /**
+     * Highest value.
+     */
+    uint8_t max;
+
+    /**
+     * Newest value, where the line continues from.
+     */
+    uint8_t last;
+} graph_column_t;
+
+/**
+ * A line on the graph.
+ */
+typedef struct {
+    /**
+     * Color of the line.
+     */
+    hsv_t color;
+
+    /**
+     * Value drawn at the top of the graph.
+     */
+    uint8_t max_value;
+
+    /**
+     * Storage for the history, must have room for ``graph_t.columns`` elements.
+     *
+     * Used as a ring buffer: a new column overwrites the one at ``graph_t.committed % graph_t.columns``, which is the
+     * oldest one.
+     */
+    graph_column_t *history;
+
+    /**
+     * Column being filled.
+     */
+    graph_column_t current;
+} graph_series_t;
+
+/**
+ * A graph and its state.
+ */
+typedef struct {
+    /**
+     * Number of columns on the graph.
+     */
+    uint16_t columns;
+
+    /**
+     * How many samples are merged into a column.
+     */
+    uint8_t samples_per_column;
+
+    /**
+     * Color of the axes.
+     */
+    hsv_t axis;
+
+    /**
+     * Color of the background.
+     */
+    hsv_t background;
+
+    /**
+     * Number of lines.
+     */
+    size_t n_series;
+
+    /**
+     * The lines.
+     */
+    graph_series_t *series;
+
+    /**
+     * Columns completed, since the graph was reset.
+     */
+    size_t committed;
+
+    /**
+     * Columns drawn, since the graph was reset.
+     */
+    size_t drawn;
+
+    /**
+     * Samples on the column being filled.
+     */
+    uint8_t samples;
+
+    /**
+     * Whether axes and history have to be drawn from scratch.
+     */
+    bool dirty;
+} graph_t;
+
+/**
+ * Forget all data.
+ */
+void graph_reset(graph_t *graph);
+
+/**
+ * Add a sample to every series.
+ *
+ * Args:
+ *     values: One value per series.
+ */
+void graph_push(graph_t *graph, const uint8_t *values);
+
+/**
+ * Draw everything again on next render, eg: after area got cleared.
+ */
+void graph_invalidate(graph_t *graph);
+
+/**
+ * Draw the columns that were completed since last call.
+ *
+ * Args:
+ *     device: Where to draw.
+ *     x: Left of the area.
+ *     y: Top of the area.
+ *     width: Size of the area, horizontally.
+ *     height: Size of the area, vertically.
+ *
+ * Return:
+ *     Whether anything was drawn.
+ */
+bool graph_render(graph_t *graph, painter_device_t device, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
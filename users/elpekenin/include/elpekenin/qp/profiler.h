@@ -0,0 +1,167 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Counters about the traffic sent to displays, to find out what is hogging the bus.
+ *
+ * Comms code reports the bytes, commands and chip select toggles of each device, along with the time spent sending
+ * them. UI nodes only report how long their render took, as traffic is not tied to them when drawing on a framebuffer.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/painter/qp.h>
+
+/**
+ * Statistics about a display.
+ */
+typedef struct PACKED {
+    /**
+     * Bytes of pixel data sent.
+     */
+    uint32_t bytes;
+
+    /**
+     * Commands sent.
+     */
+    uint32_t commands;
+
+    /**
+     * Times chip select got asserted.
+     */
+    uint32_t cs_toggles;
+
+    /**
+     * Time (us) spent sending data.
+     */
+    uint32_t send_time;
+} qp_profiler_device_stats_t;
+
+/**
+ * Current time, in microseconds.
+ *
+ * .. hint::
+ *   Will wrap around (~71 minutes), only use it to compute time deltas.
+ */
+uint32_t qp_profiler_now(void);
+
+/**
+ * Report that ``bytes`` were sent to ``device``, taking ``time`` microseconds.
+ */
+void qp_profiler_on_send(painter_device_t device, uint32_t bytes, uint32_t time);
+
+/**
+ * Report that a command was sent to ``device``.
+ */
+void qp_profiler_on_command(painter_device_t device);
+
+/**
+ * Report that chip select of ``device`` was asserted.
+ */
+void qp_profiler_on_cs_toggle(painter_device_t device);
+
+/**
+ * Get the statistics of the ``index``-th device seen.
+ *
+ * Args:
+ *     index: Position of the device.
+ *     device: Where to write the device's handle.
+ *     stats: Where to write its statistics.
+ *
+ * Return:
+ *     Whether there was such device.
+ */
+bool qp_profiler_get_device_stats(uint8_t index, painter_device_t *device, qp_profiler_device_stats_t *stats);
+
+/**
+ * Find the position of a display on the assets' registry.
+ *
+ * .. hint::
+ *   The profiler sees panels, a registry entry also matches when it is a framebuffer drawing on ``device``.
+ *
+ * Args:
+ *     device: Display seen by the profiler.
+ *     index: Where to write its position, to be used with ``get_device_*``.
+ *
+ * Return:
+ *     Whether it was registered.
+ */
+bool qp_profiler_device_index(painter_device_t device, size_t *index);
+
+/**
+ * Zero all counters.
+ */
+void qp_profiler_reset(void);
+
+#if CM_ENABLED(UI)
+#    include "elpekenin/ui.h"
+
+/**
+ * Statistics about a UI node.
+ */
+typedef struct PACKED {
+    /**
+     * Times it was rendered.
+     */
+    uint32_t renders;
+
+    /**
+     * Time (us) spent on its render function.
+     */
+    uint32_t render_time;
+} qp_profiler_node_stats_t;
+
+/**
+ * Mark ``node`` as the one being rendered.
+ */
+void qp_profiler_node_begin(const ui_node_t *node);
+
+/**
+ * Mark the end of the current node's rendering.
+ */
+void qp_profiler_node_end(void);
+
+/**
+ * Get the statistics of the ``index``-th node seen.
+ *
+ * Args:
+ *     index: Position of the node.
+ *     node: Where to write the node's address.
+ *     stats: Where to write its statistics.
+ *
+ * Return:
+ *     Whether there was such node.
+ */
+bool qp_profiler_get_node_stats(uint8_t index, const ui_node_t **node, qp_profiler_node_stats_t *stats);
+
+/**
+ * Name of the wrapper created by :c:macro:`QP_PROFILER_WRAP`.
+ */
+#    define QP_PROFILED(render) render##_profiled
+
+/**
+ * Create a wrapper around a render function, that reports the node to the profiler.
+ *
+ * .. hint::
+ *   Use as ``.render = QP_PROFILED(render)``
+ */
+#    define QP_PROFILER_WRAP(render)                                                            \
+        static ui_time_t QP_PROFILED(render)(const ui_node_t *self, painter_device_t display) { \
+            qp_profiler_node_begin(self);                                                       \
+            const ui_time_t ret = render(self, display);                                        \
+            qp_profiler_node_end();                                                             \
+            return ret;                                                                         \
+        }
+
+typedef struct {
+    const uint8_t             *font;
+    uint32_t                   last_time;
+    qp_profiler_device_stats_t last[QUANTUM_PAINTER_NUM_DISPLAYS];
+} qp_profiler_args_t;
+STATIC_ASSERT(offsetof(qp_profiler_args_t, font) == 0, "UI will crash :)");
+
+bool      qp_profiler_init(ui_node_t *self);
+ui_time_t qp_profiler_render(const ui_node_t *self, painter_device_t display);
+#endif
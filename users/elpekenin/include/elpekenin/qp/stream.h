@@ -0,0 +1,96 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Compressed pixel streams, to push big images (eg: from the host) into a display.
+ *
+ * A stream is started with :c:func:`qp_stream_begin`, which sets the viewport where pixels will be written. Then,
+ * chunks of encoded data are fed with :c:func:`qp_stream_data`, each of them with a sequence number. Chunks have to
+ * arrive in order: a repeated one is ignored, and one after a gap is rejected. The sender can then keep several of
+ * them in flight, and go back to the last accepted one when something got lost.
+ *
+ * Data is a sequence of tokens, each one starting with a header byte: lower 7 bits are ``count - 1``.
+ *   * If the top bit is set, a single pixel follows, repeated ``count`` times.
+ *   * Otherwise, ``count`` pixels follow.
+ *
+ * Depending on the encoding, a pixel is either 2 bytes, in the display's native format (same as ``qp_pixdata``), or
+ * a 1 byte index on the palette set with :c:func:`qp_stream_set_palette`.
+ *
+ * .. caution::
+ *   Tokens can't be split across chunks. A chunk using indices outside of the palette is rejected, and pixels past the
+ *   end of the region are dropped. A chunk that the display fails to draw is rejected too, re-sending it draws from
+ *   the same position again.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <quantum/painter/qp.h>
+
+#ifndef QP_STREAM_PALETTE_SIZE
+#    define QP_STREAM_PALETTE_SIZE 256
+#endif
+
+/**
+ * How pixels are encoded on a stream.
+ */
+typedef enum {
+    /**
+     * Native pixels, run-length encoded.
+     */
+    QP_STREAM_RLE,
+
+    /**
+     * Palette indices, run-length encoded.
+     */
+    QP_STREAM_PALETTE_RLE,
+} qp_stream_encoding_t;
+
+/**
+ * Start a new stream, discarding the previous one (if any).
+ *
+ * Args:
+ *     device: Where to draw.
+ *     left: Start of the region, horizontally.
+ *     top: Start of the region, vertically.
+ *     right: End of the region (inclusive), horizontally.
+ *     bottom: End of the region (inclusive), vertically.
+ *     encoding: How data will be encoded.
+ *
+ * Return:
+ *     Whether operation was successful.
+ */
+bool qp_stream_begin(painter_device_t device, uint16_t left, uint16_t top, uint16_t right, uint16_t bottom, qp_stream_encoding_t encoding);
+
+/**
+ * Set some colors on the palette.
+ *
+ * Args:
+ *     start: First position to be written.
+ *     colors: Native pixels, 2 bytes each.
+ *     count: Number of colors.
+ *
+ * Return:
+ *     Whether they fit on the palette.
+ */
+bool qp_stream_set_palette(uint16_t start, const uint8_t *colors, uint16_t count);
+
+/**
+ * Decode a chunk of data into the display.
+ *
+ * Args:
+ *     seq: Sequence number of this chunk.
+ *     data: Encoded pixels.
+ *     length: Size of ``data``.
+ *     expected: Where to write the sequence number of the next chunk to be sent.
+ *
+ * Return:
+ *     Whether the chunk was accepted. Either because it got drawn, or because it was a repetition of a previous one.
+ */
+bool qp_stream_data(uint16_t seq, const uint8_t *data, size_t length, uint16_t *expected);
+
+/**
+ * Sequence number of the next chunk to be sent.
+ */
+uint16_t qp_stream_expected(void);
@@ -6,11 +6,13 @@
 #include "elpekenin/ui.h"
 
 typedef struct {
-    ui_time_t last_draw;
-    bool      clear;
+    bool clear;
 } computer_args_t;
 
 bool      computer_init(ui_node_t *self);
 ui_time_t computer_render(const ui_node_t *self, painter_device_t display);
 
 void push_computer(uint8_t cpu, uint8_t ram);
+
+// push several samples at once, oldest first (eg: backfill after host reconnects)
+void push_computer_batch(const uint8_t *cpu, const uint8_t *ram, size_t count);
@@ -31,3 +31,25 @@ void set_sipo_pin(uint8_t pin, bool state);
  * set low/high as desired.
  */
 void send_sipo_state(void);
+
+/**
+ * Keep the shift registers' SPI driver running until :c:func:`sipo_burst_end` is called.
+ *
+ * Without this, every :c:func:`send_sipo_state` sets up (and tears down) the bus, which adds up
+ * when toggling a pin a lot, eg: a CS line around every byte sent to a device.
+ *
+ * .. caution::
+ *   Other devices on that bus can't be used in the meantime.
+ *
+ * .. hint::
+ *   Calls can be nested, the bus is released when the outermost burst ends.
+ *
+ * Return:
+ *     Whether operation was successful.
+ */
+bool sipo_burst_start(void);
+
+/**
+ * Undo the settings performed by :c:func:`sipo_burst_start`.
+ */
+void sipo_burst_end(void);
@@ -144,6 +144,20 @@ spi_status_t spi_custom_read(uint8_t n);
  */
 spi_status_t spi_custom_transmit(const uint8_t *data, uint16_t length, uint8_t n);
 
+/**
+ * Start sending ``length`` bytes from ``data`` over the ``n``'th driver, without waiting for it to finish.
+ *
+ * .. caution::
+ *   ``data`` must not be modified until the transfer is done. That is: until :c:func:`spi_custom_wait`
+ *   returns, or any other operation is performed on the same driver.
+ */
+spi_status_t spi_custom_transmit_async(const uint8_t *data, uint16_t length, uint8_t n);
+
+/**
+ * Block until the transfer started by :c:func:`spi_custom_transmit_async` on the ``n``'th driver (if any) is done.
+ */
+void spi_custom_wait(uint8_t n);
+
 /**
  * Read ``length`` bytes into ``data`` over the ``n``'th driver.
  */
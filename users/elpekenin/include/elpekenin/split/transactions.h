@@ -17,12 +17,74 @@ void transactions_init(void);
 void reset_ee_slave(void);
 
 #if IS_ENABLED(XAP) || defined(__SPHINX__)
-void xap_execute_slave(const void *data);
+#    ifndef XAP_SPLIT_QUEUE_SIZE
+#        define XAP_SPLIT_QUEUE_SIZE 8
+#    endif
 
-typedef struct PACKED {
-    uint8_t data[XAP_EPSIZE];
+#    ifndef XAP_SPLIT_RETRIES
+#        define XAP_SPLIT_RETRIES 5
+#    endif
+
+#    ifndef XAP_SLAVE_QUEUE_SIZE
+#        define XAP_SLAVE_QUEUE_SIZE 8
+#    endif
+
+#    ifndef XAP_SLAVE_RESULTS_SIZE
+#        define XAP_SLAVE_RESULTS_SIZE 16
+#    endif
+
+// queue a request for the slave, its result gets stored under `id` (see `xap_completion_get`) once it has run
+bool xap_execute_slave(const void *data, uint16_t *id);
+
+// report the outcome of the request being run on the slave, ignored on master
+void xap_slave_result(bool success);
+
+// a request, as queued on either side
+typedef struct {
+    uint16_t id;
+    uint8_t  length;
+    uint8_t  data[XAP_EPSIZE];
 } xap_split_msg_t;
-STATIC_ASSERT(sizeof(xap_split_msg_t) == XAP_EPSIZE, "wrong size for xap_split_msg_t");
+
+// a request inside of a frame, followed by `length` bytes of XAP message
+typedef struct PACKED {
+    uint16_t id;
+    uint8_t  length;
+} xap_split_entry_t;
+
+// slave has to drop its de-duplication state, master's `seq` started over
+#    define XAP_SPLIT_FRAME_SYNC (1 << 0)
+
+// several requests packed together, only `offsetof(data) + used bytes` get sent
+typedef struct PACKED {
+    uint8_t seq;
+    uint8_t count;
+    uint8_t flags;
+    uint8_t data[RPC_M2S_BUFFER_SIZE - 3];
+} xap_split_frame_t;
+STATIC_ASSERT(sizeof(xap_split_frame_t) == RPC_M2S_BUFFER_SIZE, "wrong size for xap_split_frame_t");
+STATIC_ASSERT(sizeof(xap_split_entry_t) + XAP_EPSIZE <= sizeof((xap_split_frame_t){0}.data), "XAP message does not fit in a frame");
+
+typedef struct PACKED {
+    uint8_t seq;
+    bool    accepted;
+} xap_split_ack_t;
+
+// slave holds back results until there is room for them, `queued` is how many requests are still waiting to run
+typedef struct PACKED {
+    uint8_t queued;
+    uint8_t count;
+    struct PACKED {
+        uint16_t id;
+        bool     success;
+    } results[XAP_SLAVE_RESULTS_SIZE];
+} xap_split_results_t;
+STATIC_ASSERT(sizeof(xap_split_results_t) <= RPC_S2M_BUFFER_SIZE, "wrong size for xap_split_results_t");
 #endif
 
 bool get_slave_build_id(u128 *build_id);
+
+#if IS_ENABLED(QUANTUM_PAINTER) || defined(__SPHINX__)
+// index of a device on the slave, by name. fails on slave or if it has no such device
+bool get_slave_device_index(const char *name, size_t *index);
+#endif
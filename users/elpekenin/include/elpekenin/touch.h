@@ -161,3 +161,82 @@ void report_from(int16_t x, int16_t y, touch_driver_t *driver, touch_report_t *r
  *     check_irq: Whether to check the IRQ's pin state.
  */
 touch_report_t get_spi_touch_report(touch_device_t device, bool check_irq);
+
+/**
+ * State of a filter sitting between a sensor and whoever consumes its events.
+ *
+ * Used to avoid flooding receivers with a report on every reading while the
+ * screen is held, when the point has barely (or not at all) moved.
+ */
+typedef struct {
+    /**
+     * Minimum distance (Manhattan, in pixels) from the last forwarded point.
+     */
+    uint16_t min_distance;
+
+    /**
+     * Minimum time (in ms) between two forwarded points.
+     */
+    uint16_t min_interval;
+
+    /**
+     * Whether the last reading was a press.
+     */
+    bool pressed;
+
+    /**
+     * Latest point read from the sensor.
+     */
+    touch_report_t last_seen;
+
+    /**
+     * Latest point forwarded to receivers.
+     */
+    touch_report_t last_sent;
+
+    /**
+     * When was ``last_sent`` forwarded.
+     */
+    uint32_t last_time;
+} touch_filter_t;
+
+/**
+ * Events to be forwarded after filtering a reading.
+ *
+ * .. hint::
+ *   Values are flags, both can be set at once. If so, the point is to be sent before the release.
+ */
+typedef enum {
+    /**
+     * Nothing to do.
+     */
+    TOUCH_FILTER_NONE = 0,
+
+    /**
+     * Forward the point written to the output.
+     */
+    TOUCH_FILTER_POINT = (1 << 0),
+
+    /**
+     * Forward a release.
+     */
+    TOUCH_FILTER_RELEASE = (1 << 1),
+} touch_filter_result_t;
+
+/**
+ * Check whether a reading has to be forwarded.
+ *
+ * Rules applied:
+ *    * First point of a press is always forwarded.
+ *    * While pressed, points are only forwarded if both ``min_distance`` and ``min_interval`` are exceeded.
+ *    * Upon release, last point seen is forwarded (if it had been filtered), followed by the release.
+ *
+ * Args:
+ *     filter: State of the filter, updated by this function.
+ *     report: Latest reading from the sensor.
+ *     point: Output to be filled with the point that has to be forwarded.
+ *
+ * Return:
+ *     Events that have to be sent.
+ */
+touch_filter_result_t touch_filter_apply(touch_filter_t *filter, touch_report_t report, touch_report_t *point);
@@ -0,0 +1,60 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/**
+ * Non-blocking transmission over UART, shared by everything using it (logging, M5, ...).
+ *
+ * Data is copied into a ring buffer and sent in the background, topping up the peripheral's FIFO every millisecond,
+ * so that callers never wait for the wire.
+ *
+ * Writes are queued whole or not at all: when there isn't room for all of it, the new data gets dropped, keeping
+ * whatever was queued before. This way, the receiving end never sees a truncated message. The amount of bytes lost
+ * is tracked, see :c:func:`uart_tx_dropped`.
+ *
+ * .. caution::
+ *   Functions are not thread-safe, they must only be called from QMK's main loop.
+ */
+
+// -- barrier --
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Configure the peripheral.
+ *
+ * .. hint::
+ *   Calling it more than once is fine, baud rate is set by the first call.
+ *
+ * Args:
+ *     baud: Speed of the link.
+ *
+ * Return:
+ *     Whether the link runs at ``baud``. That is, ``false`` if a previous call configured a different speed.
+ */
+bool uart_tx_init(uint32_t baud);
+
+/**
+ * Queue data to be sent.
+ *
+ * Args:
+ *     data: Pointer to the information.
+ *     length: Amount of bytes.
+ *
+ * Return:
+ *     Whether data was queued. If not, none of it will be sent.
+ */
+bool uart_tx_write(const void *data, size_t length);
+
+/**
+ * Bytes waiting to be sent.
+ */
+size_t uart_tx_pending(void);
+
+/**
+ * Bytes dropped due to the buffer being full, since boot.
+ */
+uint32_t uart_tx_dropped(void);
@@ -17,9 +17,82 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#ifndef XAP_COMPLETIONS_SIZE
+#    define XAP_COMPLETIONS_SIZE 16
+#endif
+
+/**
+ * First byte on the payload of successful responses whose result is not known yet (eg: forwarded to the other half,
+ * or long-running), followed by the ``u16`` id to be queried with :c:func:`xap_completion_get`.
+ *
+ * Flags on the response header are left alone, as the unused bits are reserved by XAP. Payload is then 3 bytes long,
+ * no route answering with 3 bytes uses this value as its first one.
+ */
+#define XAP_DEFERRED_MARKER 0xDE
+
 void xap_last_activity_update(void);
 
 uint32_t xap_last_activity_time(void);
 uint32_t xap_last_activity_elapsed(void);
+
+/**
+ * Status of a deferred request.
+ */
+typedef enum {
+    /**
+     * No such request, or it is too old and got forgotten.
+     */
+    XAP_COMPLETION_UNKNOWN,
+
+    /**
+     * Still running.
+     */
+    XAP_COMPLETION_PENDING,
+
+    /**
+     * Finished successfully.
+     */
+    XAP_COMPLETION_SUCCESS,
+
+    /**
+     * Finished with an error.
+     */
+    XAP_COMPLETION_FAILURE,
+
+    /**
+     * Result could not be retrieved (eg: link to the other half failed), it may or may not have run.
+     */
+    XAP_COMPLETION_LOST,
+} xap_completion_t;
+
+/**
+ * Track a new request, whose result will be known later on.
+ *
+ * .. hint::
+ *   Only the last ``XAP_COMPLETIONS_SIZE`` requests are kept around.
+ *
+ * Return:
+ *     Identifier for it (never ``0``).
+ */
+uint16_t xap_completion_new(void);
+
+/**
+ * Store the result of a request.
+ */
+void xap_completion_done(uint16_t id, bool success);
+
+/**
+ * Give up on knowing the result of a request.
+ *
+ * .. hint::
+ *   If it shows up later on, :c:func:`xap_completion_done` still stores it.
+ */
+void xap_completion_lost(uint16_t id);
+
+/**
+ * Get the status of a request.
+ */
+xap_completion_t xap_completion_get(uint16_t id);
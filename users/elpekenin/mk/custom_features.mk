@@ -17,10 +17,17 @@ endif
 TOUCH_SCREEN_ENABLE ?= no
 ifeq ($(strip $(TOUCH_SCREEN_ENABLE)), yes)
     QUANTUM_LIB_SRC += spi_master.c
-    SRC += $(USER_SRC)/touch/driver.c
+    SRC += \
+        $(USER_SRC)/touch/driver.c \
+        $(USER_SRC)/touch/filter.c
+endif
+
+UART_DRIVER_REQUIRED ?= no
+ifeq ($(strip $(UART_DRIVER_REQUIRED)), yes)
+    SRC += $(USER_SRC)/uart_tx.c
 endif
 
 M5_ENABLE ?= no
-ifeq ($(strip $(TOUCH_SCREEN_ENABLE)), yes)
+ifeq ($(strip $(M5_ENABLE)), yes)
     SRC += $(USER_SRC)/m5/m5.c
 endif
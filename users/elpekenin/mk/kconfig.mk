@@ -116,15 +116,18 @@ XAP_ENABLE=yes
 #
 SIPO_PINS_ENABLE=yes
 N_SIPO_PINS=8
-# AUTOCONF_FW_CHECK is not set
+UART_TX_BUFFER_SIZE=512
 
 #
 # logging
 #
+LOG_LINE_SIZE=80
+LOG_LINE_FLUSH_DELAY=50
 QP_LOG_ENABLE=yes
 QP_LOG_N_CHARS=70
 QP_LOG_N_LINES=13
 QP_LOGGING_UI_REDRAW_INTERVAL=100
+QP_LOG_UI_WRAP=yes
 # SPLIT_LOG_ENABLE is not set
 # UART_LOG_ENABLE is not set
 # XAP_LOG_ENABLE is not set
@@ -134,6 +137,20 @@ QP_LOGGING_UI_REDRAW_INTERVAL=100
 # quantum painter
 #
 QP_ASSETS_SIZE=30
+QP_FRAMEBUFFER_ENABLE=yes
+QP_FRAMEBUFFER_TILE_SIZE=16
+QP_FRAMEBUFFER_SLICE_SIZE=4096
+QP_FRAMEBUFFER_FRAME_BUDGET=16384
+QP_EINK_DIFF_ENABLE=yes
+QP_EINK_FULL_REFRESH_INTERVAL=10
+QP_EINK_MIN_REFRESH_INTERVAL=5000
+QP_PROFILER_ENABLE=yes
+QP_PROFILER_NODES=16
+QP_PROFILER_UI_REDRAW_INTERVAL=1000
+QP_DISPLAY_LIST_ENABLE=yes
+QP_DISPLAY_LIST_SIZE=512
+QP_STREAM_ENABLE=yes
+QP_STREAM_PALETTE_SIZE=256
 
 #
 # ui
@@ -143,6 +160,7 @@ QP_ASSETS_SIZE=30
 # computer stats
 #
 COMPUTER_STATS_SIZE=30
+COMPUTER_STATS_DECIMATION=1
 COMPUTER_STATS_UI_REDRAW_INTERVAL=500
 COMPUTER_STATS_UI_TIMEOUT=5000
 # end of computer stats
@@ -163,6 +181,8 @@ GITHUB_NOTIFICATIONS_UI_TIMEOUT=5000
 # end of quantum painter
 
 TOUCH_SCREEN_ENABLE=yes
+TOUCH_FILTER_MIN_DISTANCE=3
+TOUCH_FILTER_MIN_INTERVAL=200
 M5_ENABLE=yes
 M5_DEBUG=yes
 M5_BAUD_RATE=115200
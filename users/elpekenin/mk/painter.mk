@@ -1,10 +1,32 @@
 UI := $(USER_SRC)/qp/ui
 
 ifeq ($(strip $(QUANTUM_PAINTER_ENABLE)), yes)
-    SRC += $(USER_SRC)/qp/assets.c
+    SRC += \
+        $(USER_SRC)/qp/assets.c \
+        $(USER_SRC)/qp/graph.c
 
     SRC += \
         $(UI)/build_match.c \
         $(UI)/computer.c \
         $(UI)/github.c
+
+    ifeq ($(strip $(QP_FRAMEBUFFER_ENABLE)), yes)
+        SRC += $(USER_SRC)/qp/framebuffer.c
+    endif
+
+    ifeq ($(strip $(QP_DISPLAY_LIST_ENABLE)), yes)
+        SRC += $(USER_SRC)/qp/display_list.c
+    endif
+
+    ifeq ($(strip $(QP_EINK_DIFF_ENABLE)), yes)
+        SRC += $(USER_SRC)/qp/eink.c
+    endif
+
+    ifeq ($(strip $(QP_STREAM_ENABLE)), yes)
+        SRC += $(USER_SRC)/qp/stream.c
+    endif
+
+    ifeq ($(strip $(QP_PROFILER_ENABLE)), yes)
+        SRC += $(USER_SRC)/qp/profiler.c
+    endif
 endif
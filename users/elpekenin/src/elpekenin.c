@@ -14,11 +14,6 @@
 #include "elpekenin/signatures.h"
 #include "elpekenin/split/transactions.h"
 
-// compat: QFF/QGF files have `#include <qp.h>`, which fails if feature is disabled
-#if IS_ENABLED(QUANTUM_PAINTER)
-#    include "generated/qp_resources.h"
-#endif
-
 // compat: includes effect files which fail with RGB disabled
 #if IS_ENABLED(RGB_MATRIX)
 #    include <quantum/rgb_matrix/rgb_matrix.h>
@@ -28,6 +23,10 @@
 #    include "elpekenin/crash.h"
 #endif
 
+#if IS_ENABLED(QP_FRAMEBUFFER)
+#    include "elpekenin/qp/framebuffer.h"
+#endif
+
 // clang-format off
 KEYCODE_STRING_NAMES_USER(
     // aliases
@@ -79,10 +78,6 @@ void keyboard_post_init_user(void) {
     }
 #endif
 
-#if IS_ENABLED(QUANTUM_PAINTER)
-    load_qp_resources();
-#endif
-
     if (IS_DEFINED(SPLIT_KEYBOARD)) {
         transactions_init();
     }
@@ -109,6 +104,12 @@ bool shutdown_user(bool jump_to_bootloader) {
     if (IS_ENABLED(QUANTUM_PAINTER)) {
         for (size_t i = 0; i < get_num_devices(); ++i) {
             painter_device_t device = get_device_by_index(i);
+
+#if IS_ENABLED(QP_FRAMEBUFFER)
+            // registry may hold a surface, turn off the actual display
+            device = qp_framebuffer_target(device);
+#endif
+
             qp_power(device, false);
         }
     }
@@ -1,6 +1,8 @@
 // Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "elpekenin/logging/backend.h"
+
 #include <quantum/quantum.h>
 
 #include "elpekenin/logging/backends/qp.h"
@@ -20,39 +22,98 @@ static init_func_t init_functions[] = {
 #endif
 };
 
-static sendchar_func_t send_functions[] = {
-    // default logging provided by QMK
-    //    - USB via console endpoint, if CONSOLE_ENABLE
-    //    - no-op otherwise
-    sendchar,
+// default logging provided by QMK
+//    - USB via console endpoint, if CONSOLE_ENABLE
+//    - no-op otherwise
+static int8_t write_console(const char *data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        sendchar(data[i]);
+    }
+
+    return 0;
+}
+
+static write_func_t write_functions[] = {
+    write_console,
 
 #if IS_ENABLED(QP_LOG)
-    sendchar_qp,
+    write_qp,
 #endif
 
 #if IS_ENABLED(SPLIT_LOG)
-    sendchar_split,
+    write_split,
 #endif
 
 #if IS_ENABLED(UART_LOG)
-    sendchar_uart,
+    write_uart,
 #endif
 
 #if IS_ENABLED(XAP_LOG)
-    sendchar_xap,
+    write_xap,
 #endif
 };
 
-static int8_t user_sendchar(uint8_t chr) {
-    for (size_t i = 0; i < ARRAY_SIZE(send_functions); ++i) {
-        sendchar_func_t function = send_functions[i];
+// chars are gathered here, and handed to backends a whole line at a time
+static struct {
+    char        buff[LOG_LINE_SIZE];
+    size_t      length;
+    log_level_t level;
+    bool        start; // next char begins a new line
+} line = {
+    .start = true,
+};
 
-        const int8_t ret = function(chr);
+static deferred_token token = INVALID_DEFERRED_TOKEN;
+
+log_level_t logging_line_level(void) {
+    return line.level;
+}
+
+static void flush(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(write_functions); ++i) {
+        write_func_t function = write_functions[i];
+
+        const int8_t ret = function(line.buff, line.length);
         if (ret < 0) {
             // error
         }
     }
 
+    line.length = 0;
+}
+
+static uint32_t flush_cb(__unused uint32_t trigger_time, __unused void *cb_arg) {
+    token = INVALID_DEFERRED_TOKEN;
+
+    if (line.length > 0) {
+        flush();
+    }
+
+    return 0;
+}
+
+static int8_t user_sendchar(uint8_t chr) {
+    // by the time line gets flushed, another message (with different level) may be printing
+    if (line.start) {
+        line.level = get_current_message_level();
+        line.start = false;
+    }
+
+    line.buff[line.length++] = chr;
+
+    if (chr == '\n') {
+        line.start = true;
+    }
+
+    if (chr == '\n' || line.length == sizeof(line.buff)) {
+        flush();
+    }
+
+    // don't keep a partial line (eg: a prompt) waiting forever
+    if (line.length > 0 && token == INVALID_DEFERRED_TOKEN) {
+        token = defer_exec(LOG_LINE_FLUSH_DELAY, flush_cb, NULL);
+    }
+
     return 0;
 }
 
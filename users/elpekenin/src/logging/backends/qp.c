@@ -7,69 +7,97 @@
 #include <quantum/compiler_support.h>
 #include <quantum/quantum.h>
 
+#include "elpekenin/qp/assets.h"
+
 STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
 #include "elpekenin/logging.h"
+#include "elpekenin/logging/backend.h"
 
 typedef struct {
-    char       *ptr;
+    char        text[QP_LOG_N_CHARS];
     log_level_t level;
+    bool        dirty; // changed since last drawn
 } log_line_t;
 
+// circular buffer, `head` being the line currently written
 static struct {
-    char       buff[QP_LOG_N_LINES][QP_LOG_N_CHARS];
-    size_t     col;
-    ui_time_t  last_update;
     log_line_t lines[QP_LOG_N_LINES];
+    size_t     head;
+    size_t     col;
+    bool       dirty; // any line changed
 } qp_log = {0};
 
+static void mark_dirty(size_t index) {
+    qp_log.lines[index].dirty = true;
+    qp_log.dirty              = true;
+}
+
 //
-// sendchar implementation (buffering)
+// backend implementation (buffering)
 //
 
 void sendchar_qp_init(void) {
     for (size_t i = 0; i < QP_LOG_N_LINES; ++i) {
-        qp_log.lines[i].ptr = qp_log.buff[i];
+        mark_dirty(i);
     }
 }
 
-int8_t sendchar_qp(uint8_t chr) {
-    log_line_t *const last_line = &qp_log.lines[QP_LOG_N_LINES - 1];
+static void newline(void) {
+    qp_log.head = (qp_log.head + 1) % QP_LOG_N_LINES;
+    qp_log.col  = 0;
 
-    // no-op, always appending a terminator upon writing a char
-    if (chr == '\0') {
-        return 0;
-    }
+    log_line_t *const line = &qp_log.lines[qp_log.head];
 
-    // newline, move everything 1 line upwards
-    if (chr == '\n') {
-        log_line_t overwritten = qp_log.lines[0];
+    line->text[0] = '\0';
+    line->level   = LOG_NONE;
 
-        memmove(qp_log.lines, qp_log.lines + 1, sizeof(log_line_t) * (QP_LOG_N_LINES - 1));
+#if IS_ENABLED(QP_LOG_UI_WRAP)
+    // lines are drawn in place, only the new one and the separator after it changed
+    mark_dirty(qp_log.head);
+    mark_dirty((qp_log.head + 1) % QP_LOG_N_LINES);
+#else
+    // every line moves 1 position upwards
+    sendchar_qp_init();
+#endif
+}
 
-        qp_log.col = 0;
-        *last_line = (log_line_t){
-            .ptr   = overwritten.ptr,
-            .level = LOG_NONE,
-        };
-        *last_line->ptr = '\0';
+int8_t write_qp(const char *data, size_t length) {
+    int8_t ret = 0;
 
-        goto exit;
-    }
+    for (size_t i = 0; i < length; ++i) {
+        const char chr = data[i];
 
-    // exhausted buffer
-    if (qp_log.col >= (QP_LOG_N_CHARS - 1)) {
-        return -1;
-    }
+        // no-op, always appending a terminator
+        if (chr == '\0') {
+            continue;
+        }
+
+        if (chr == '\n') {
+            newline();
+            continue;
+        }
 
-    // regular buffering
-    last_line->ptr[qp_log.col++] = chr;
-    last_line->ptr[qp_log.col]   = '\0';
+        // exhausted buffer
+        if (qp_log.col >= (QP_LOG_N_CHARS - 1)) {
+            ret = -1;
+            continue;
+        }
 
-    last_line->level = get_current_message_level();
+        log_line_t *const line = &qp_log.lines[qp_log.head];
 
-exit:
-    qp_log.last_update = ui_time_now();
-    return 0;
+        // regular buffering
+        line->text[qp_log.col++] = chr;
+        line->text[qp_log.col]   = '\0';
+
+        line->level = logging_line_level();
+        mark_dirty(qp_log.head);
+    }
+
+    return ret;
+}
+
+int8_t sendchar_qp(uint8_t chr) {
+    return write_qp((const char *)&chr, 1);
 }
 
 void qp_log_clear(void) {
@@ -99,44 +127,75 @@ bool qp_logging_init(ui_node_t *self) {
     return ui_font_fits(self);
 }
 
+#    if IS_ENABLED(QP_LOG_UI_WRAP)
+// the oldest line is not drawn, a separator goes in its place, so that it is clear where the log continues
+static bool is_separator(size_t index) {
+    return index == (qp_log.head + 1) % QP_LOG_N_LINES;
+}
+#    endif
+
+// position on screen for the line at `index` on the buffer
+static size_t row_for(size_t index) {
+#    if IS_ENABLED(QP_LOG_UI_WRAP)
+    return index;
+#    else
+    // oldest line (right after head) at the top
+    return (index + QP_LOG_N_LINES - qp_log.head - 1) % QP_LOG_N_LINES;
+#    endif
+}
+
 ui_time_t qp_logging_render(const ui_node_t *self, painter_device_t display) {
     qp_logging_args_t *args = self->args;
 
-    if (ui_time_lte(qp_log.last_update, args->last_draw)) {
+    if (!qp_log.dirty) {
         goto exit;
     }
 
-    const painter_font_handle_t font = qp_load_font_mem(args->font);
+    const painter_font_handle_t font = acquire_font(args->font);
     if (font == NULL) {
         goto exit;
     }
 
-    // clear
-    qp_rect(display, self->start.x, self->start.y, self->start.x + self->size.x, self->start.y + self->size.y, HSV_BLACK, true);
-
     for (size_t i = 0; i < QP_LOG_N_LINES; ++i) {
-        const uint16_t y = self->start.y + (i * font->line_height);
+        log_line_t *const line = &qp_log.lines[i];
 
-        // can't fit more lines
+        if (!line->dirty) {
+            continue;
+        }
+
+        line->dirty = false;
+
+        const uint16_t y = self->start.y + (row_for(i) * font->line_height);
+
+        // can't fit this line
         if ((y + font->line_height) > self->size.y) {
-            break;
+            continue;
         }
 
-        log_line_t *const line = &qp_log.lines[i];
+        // clear just this line
+        qp_rect(display, self->start.x, y, self->start.x + self->size.x, y + font->line_height - 1, HSV_BLACK, true);
+
+#    if IS_ENABLED(QP_LOG_UI_WRAP)
+        if (is_separator(i)) {
+            const uint16_t middle = y + (font->line_height / 2);
+            qp_line(display, self->start.x, middle, self->start.x + self->size.x, middle, HSV_WHITE);
+            continue;
+        }
+#    endif
 
         const hsv_t fg = log_colors[line->level];
         const hsv_t bg = {HSV_BLACK};
 
-        if (!ui_text_fits(self, font, line->ptr)) {
+        if (!ui_text_fits(self, font, line->text)) {
             continue;
         }
 
-        qp_drawtext_recolor(display, self->start.x, y, font, line->ptr, fg.h, fg.s, fg.v, bg.h, bg.s, bg.v);
+        qp_drawtext_recolor(display, self->start.x, y, font, line->text, fg.h, fg.s, fg.v, bg.h, bg.s, bg.v);
     }
 
-    qp_close_font(font);
+    release_font(font);
 
-    args->last_draw = ui_time_now();
+    qp_log.dirty = false;
 
 exit:
     return (ui_time_t)UI_MILLISECONDS(QP_LOGGING_UI_REDRAW_INTERVAL);
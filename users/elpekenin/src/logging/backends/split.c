@@ -30,20 +30,26 @@ static char rbuf_inner[SPLIT_LOG_BUFFER_SIZE] = {0};
 // slave will write on its copy of this variable, master will copy (over split) onto its own
 static RingBuffer(char) rbuf = rbuf_from(char, rbuf_inner);
 
-int8_t sendchar_split(uint8_t chr) {
+int8_t write_split(const char* data, size_t length) {
     // on master, this does nothing
     if (is_keyboard_master()) {
         return 0;
     }
 
-    const bool pushed = rbuf_push(rbuf, chr);
-    if (!pushed) {
-        return -1;
+    for (size_t i = 0; i < length; ++i) {
+        const bool pushed = rbuf_push(rbuf, data[i]);
+        if (!pushed) {
+            return -1;
+        }
     }
 
     return 0;
 }
 
+int8_t sendchar_split(uint8_t chr) {
+    return write_split((const char*)&chr, 1);
+}
+
 void logging_handler(__unused uint8_t m2s_size, __unused const void* m2s_buffer, __unused uint8_t s2m_size, void* s2m_buffer) {
     split_logging_t data = {0};
 
@@ -1,9 +1,10 @@
 // Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
-#include <drivers/uart.h>
 #include <quantum/quantum.h>
 
+#include "elpekenin/uart_tx.h"
+
 typedef enum {
     CLIENT_NONE,
     CLIENT_PUTTY,
@@ -29,22 +30,48 @@ static const escape_sequences_t sequences[] = {
 
 static const escape_sequences_t sequence = sequences[UART_CLIENT];
 
+// link is shared, and may have been configured (eg: by M5) at another speed
+static bool enabled = false;
+
 void sendchar_uart_init(void) {
-    uart_init(UART_LOG_BAUD_RATE);
+    enabled = uart_tx_init(UART_LOG_BAUD_RATE);
+    if (!enabled) {
+        return;
+    }
 
-    uart_transmit((const uint8_t *)sequence.clear, strlen(sequence.clear));
-    uart_transmit((const uint8_t *)sequence.cursor, strlen(sequence.cursor));
+    if (sequence.clear != NULL) {
+        uart_tx_write(sequence.clear, strlen(sequence.clear));
+    }
+
+    if (sequence.cursor != NULL) {
+        uart_tx_write(sequence.cursor, strlen(sequence.cursor));
+    }
 }
 
-int8_t sendchar_uart(uint8_t chr) {
-    // TODO: buffering?
+int8_t write_uart(const char *data, size_t length) {
+    if (!enabled) {
+        return -1;
+    }
+
+    size_t start = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (data[i] != '\n') {
+            continue;
+        }
+
+        // make PuTTY correctly print next line
+        // without this, it doesn't roll back to start of line
+        uart_tx_write(&data[start], i - start);
+        uart_tx_write("\r\n", 2);
 
-    // make PuTTY correctly print next line
-    // without this, it doesn't roll back to start of line
-    if (chr == '\n') {
-        uart_write('\r');
+        start = i + 1;
     }
 
-    uart_write(chr);
+    uart_tx_write(&data[start], length - start);
     return 0;
 }
+
+int8_t sendchar_uart(uint8_t chr) {
+    return write_uart((const char *)&chr, 1);
+}
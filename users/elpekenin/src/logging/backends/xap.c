@@ -1,47 +1,68 @@
 // Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
-#include <quantum/compiler_support.h>
 #include <quantum/quantum.h>
 #include <tmk_core/protocol/usb_descriptor.h>
 
-STATIC_ASSERT(CM_ENABLED(GENERICS), "Must enable 'elpekenin/generics'");
-#include "elpekenin/generics.h"
+#ifndef XAP_LOG_FLUSH_DELAY
+#    define XAP_LOG_FLUSH_DELAY 20
+#endif
 
-#define MAX_PAYLOAD_SIZE (XAP_EPSIZE - sizeof(xap_broadcast_header_t)) // -1 for terminator
+#define MAX_PAYLOAD_SIZE (XAP_EPSIZE - sizeof(xap_broadcast_header_t))
+#define MAX_DATA_SIZE (MAX_PAYLOAD_SIZE - sizeof(uint8_t)) // -1 for length
 
-OptionImpl(char);
-RingBufferImpl(char);
+// logs are a stream, lines may be split across packets
+typedef struct PACKED {
+    uint8_t length;
+    char    data[MAX_DATA_SIZE];
+} log_packet_t;
 
-static char rbuf_inner[XAP_LOG_BUFFER_SIZE] = {0};
+static log_packet_t   packet = {0};
+static deferred_token token  = INVALID_DEFERRED_TOKEN;
 
-static RingBuffer(char) rbuf = rbuf_from(char, rbuf_inner);
+static void flush(void) {
+    if (packet.length == 0) {
+        return;
+    }
 
-int8_t sendchar_xap(uint8_t chr) {
-    const bool pushed = rbuf_push(rbuf, chr);
+    xap_broadcast(0x00, &packet, sizeof(packet.length) + packet.length);
+    packet.length = 0;
+}
 
-    // buffered
-    if (chr != '\n' && pushed) {
-        return 0;
-    }
+static uint32_t flush_cb(__unused uint32_t trigger_time, __unused void *cb_arg) {
+    token = INVALID_DEFERRED_TOKEN;
+    flush();
+    return 0;
+}
+
+int8_t write_xap(const char *data, size_t length) {
+    while (length > 0) {
+        const size_t chunk = MIN(length, MAX_DATA_SIZE - packet.length);
 
-    // send
-    char xap_buff[MAX_PAYLOAD_SIZE] = {0};
-    for (size_t i = 0; i < MAX_PAYLOAD_SIZE - 1; ++i) {
-        const Option(char) pop = rbuf_pop(rbuf);
-        if (!pop.is_some) {
-            break;
+        memcpy(&packet.data[packet.length], data, chunk);
+        packet.length += chunk;
+
+        data += chunk;
+        length -= chunk;
+
+        if (packet.length == MAX_DATA_SIZE) {
+            flush();
         }
+    }
 
-        xap_buff[i]     = unwrap(pop);
-        xap_buff[i + 1] = '\0';
+    // send whatever is left after a while, unless more data fills the packet first
+    if (packet.length > 0 && token == INVALID_DEFERRED_TOKEN) {
+        token = defer_exec(XAP_LOG_FLUSH_DELAY, flush_cb, NULL);
     }
-    xap_broadcast(0x00, xap_buff, MAX_PAYLOAD_SIZE);
 
-    // failed to push before, do it now that buffer was sent
-    if (!pushed) {
-        assert(rbuf_push(rbuf, chr) == true);
+    // scheduling failed, don't keep data around
+    if (token == INVALID_DEFERRED_TOKEN) {
+        flush();
     }
 
     return 0;
 }
+
+int8_t sendchar_xap(uint8_t chr) {
+    return write_xap((const char *)&chr, 1);
+}
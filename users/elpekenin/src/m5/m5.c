@@ -3,10 +3,21 @@
 
 #include "elpekenin/m5.h"
 
-#include "uart.h"
+#include <quantum/compiler_support.h>
+
+#include "elpekenin/uart_tx.h"
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+// link is shared, and may have been configured (eg: by UART logging) at another speed
+static bool enabled = false;
 
 void m5_init(void) {
-    uart_init(M5_BAUD_RATE);
+    enabled = uart_tx_init(M5_BAUD_RATE);
+    if (!enabled) {
+        logging(LOG_ERROR, "%s: UART is already in use at another baud rate", __func__);
+    }
 }
 
 void m5_send(const void *data, size_t data_len) {
@@ -19,5 +30,11 @@ void m5_send(const void *data, size_t data_len) {
         printf(" }\n");
     }
 
-    uart_transmit(ptr, data_len);
+    if (!enabled) {
+        return;
+    }
+
+    if (!uart_tx_write(ptr, data_len)) {
+        logging(LOG_WARN, "%s: message dropped", __func__);
+    }
 }
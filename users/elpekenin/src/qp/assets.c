@@ -7,175 +7,428 @@
 #include <quantum/quantum.h>
 #include <quantum/util.h>
 
+#include "generated/qp_resources.h"
+
 STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
 #include "elpekenin/logging.h"
 
-typedef enum {
-    EMPTY,
-    DEVICE,
-    FONT,
-    IMAGE,
-} asset_kind_t;
-
-static const char *asset_names[] = {
-    [EMPTY]  = "empty",
-    [DEVICE] = "device",
-    [FONT]   = "font",
-    [IMAGE]  = "image",
-};
+// FNV-1a, with the seed mixed into the offset basis
+// NOTE: must match the implementation in `qp_resources.py`
+uint32_t qp_asset_hash(uint32_t seed, const char *name) {
+    uint32_t hash = 2166136261u ^ seed;
+
+    for (; *name != '\0'; ++name) {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//
+// devices: registered at runtime, open addressing with linear probing
+//
 
-typedef struct PACKED {
-    asset_kind_t kind;
-    const char  *name;
-    const void  *ptr;
-} asset_t;
+typedef struct {
+    uint32_t         hash;
+    const char      *name;
+    painter_device_t device;
+} device_slot_t;
 
 static struct {
-    size_t devices;
-    size_t fonts;
-    size_t images;
-} count = {0};
+    device_slot_t slots[QP_ASSETS_SIZE];
+    uint16_t      order[QP_ASSETS_SIZE]; // slot of each device, in registration order
+    size_t        count;
+} devices = {0};
 
-static asset_t assets[QP_ASSETS_SIZE] = {0};
+void set_device_by_name(const char *name, painter_device_t device) {
+    const uint32_t hash  = qp_asset_hash(0, name);
+    const size_t   start = hash % QP_ASSETS_SIZE;
 
-static inline size_t total_count(void) {
-    return count.devices + count.fonts + count.images;
-}
+    for (size_t i = 0; i < QP_ASSETS_SIZE; ++i) {
+        const size_t         index = (start + i) % QP_ASSETS_SIZE;
+        device_slot_t *const slot  = &devices.slots[index];
 
-static void set(asset_kind_t kind, const char *name, const void *ptr) {
-    const size_t n = total_count();
-    if (n >= QP_ASSETS_SIZE) {
-        logging(LOG_ERROR, "%s: too many assets", __func__);
-        return;
+        if (slot->device == NULL) {
+            *slot = (device_slot_t){
+                .hash   = hash,
+                .name   = name,
+                .device = device,
+            };
+
+            devices.order[devices.count] = index;
+            devices.count += 1;
+
+            logging(LOG_DEBUG, "Stored device '%s'(%p) at slot %d", name, device, index);
+            return;
+        }
+
+        // lookups only compare hashes, can't have two names with the same one
+        if (slot->hash == hash) {
+            if (strcmp(slot->name, name) != 0) {
+                logging(LOG_ERROR, "%s: '%s' collides with '%s'", __func__, name, slot->name);
+                return;
+            }
+
+            slot->device = device;
+            logging(LOG_DEBUG, "Updated device '%s'(%p)", name, device);
+            return;
+        }
     }
 
-    assets[n] = (asset_t){
-        .kind = kind,
-        .name = name,
-        .ptr  = ptr,
-    };
+    logging(LOG_ERROR, "%s: too many devices", __func__);
+}
 
-    const char *asset_name = asset_names[kind];
-    logging(LOG_DEBUG, "Stored %s '%s'(%p) at index %d of assets pool", asset_name, name, ptr, n);
+painter_device_t get_device_by_name(const char *name) {
+    const uint32_t hash  = qp_asset_hash(0, name);
+    const size_t   start = hash % QP_ASSETS_SIZE;
 
-    switch (kind) {
-        case EMPTY:
-            __unreachable();
+    for (size_t i = 0; i < QP_ASSETS_SIZE; ++i) {
+        const device_slot_t *const slot = &devices.slots[(start + i) % QP_ASSETS_SIZE];
 
-        case DEVICE:
-            count.devices += 1;
+        if (slot->device == NULL) {
             break;
+        }
 
-        case FONT:
-            count.fonts += 1;
-            break;
+        if (slot->hash == hash) {
+            logging(LOG_DEBUG, "(device, '%s'): %p", name, slot->device);
+            return slot->device;
+        }
+    }
 
-        case IMAGE:
-            count.images += 1;
-            break;
+    logging(LOG_ERROR, "(device, '%s'): not found", name);
+    return NULL;
+}
+
+bool get_device_index(const char *name, size_t *index) {
+    const uint32_t hash = qp_asset_hash(0, name);
+
+    for (size_t i = 0; i < devices.count; ++i) {
+        if (devices.slots[devices.order[i]].hash == hash) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t get_num_devices(void) {
+    return devices.count;
+}
+
+painter_device_t get_device_by_index(size_t index) {
+    if (index >= devices.count) {
+        logging(LOG_ERROR, "(device, %d): not found", index);
+        return NULL;
+    }
+
+    return devices.slots[devices.order[index]].device;
+}
+
+const char *get_device_name(size_t index) {
+    if (index >= devices.count) {
+        return NULL;
     }
+
+    return devices.slots[devices.order[index]].name;
 }
 
-// NOTE: get_by_index(FONT, 3) is not 3rd element in pool, but the third *font* in pool
-static const void *get_by_index(asset_kind_t kind, size_t index) {
-    const char *const type = asset_names[kind];
+//
+// handle cache: opening an asset parses its header, keep them around for the next user
+//
 
-    size_t counter = 0;
+typedef struct {
+    const void *data;
+    const void *handle;
+    uint16_t    refs;
+    bool        pinned; // used by something that never ends, eg: an animation
+    uint32_t    last_used;
+} cache_entry_t;
+
+typedef struct {
+    cache_entry_t *entries;
+    size_t         size;
+    const char    *kind;
+    const void *(*load)(const void *data);
+    void (*close)(const void *handle);
+} cache_t;
+
+static uint32_t cache_tick = 0;
+
+static const void *load_font(const void *data) {
+    return qp_load_font_mem(data);
+}
 
-    const asset_t *asset = NULL;
-    for (size_t i = 0; i < total_count(); ++i) {
-        const asset_t *ptr = &assets[i];
+static void close_font(const void *handle) {
+    qp_close_font(handle);
+}
 
-        if (ptr->kind == kind) {
-            if (counter == index) {
-                asset = ptr;
-                break;
-            }
+static const void *load_image(const void *data) {
+    return qp_load_image_mem(data);
+}
+
+static void close_image(const void *handle) {
+    qp_close_image(handle);
+}
 
-            counter += 1;
+static cache_entry_t font_entries[QUANTUM_PAINTER_NUM_FONTS]   = {0};
+static cache_entry_t image_entries[QUANTUM_PAINTER_NUM_IMAGES] = {0};
+
+static const cache_t font_cache = {
+    .entries = font_entries,
+    .size    = ARRAY_SIZE(font_entries),
+    .kind    = "font",
+    .load    = load_font,
+    .close   = close_font,
+};
+
+static const cache_t image_cache = {
+    .entries = image_entries,
+    .size    = ARRAY_SIZE(image_entries),
+    .kind    = "image",
+    .load    = load_image,
+    .close   = close_image,
+};
+
+// find the entry for `data`, or make room for it
+static cache_entry_t *cache_entry(const cache_t *cache, const void *data) {
+    cache_entry_t *empty = NULL;
+    cache_entry_t *lru   = NULL;
+
+    for (size_t i = 0; i < cache->size; ++i) {
+        cache_entry_t *const entry = &cache->entries[i];
+
+        if (entry->handle == NULL) {
+            empty = empty == NULL ? entry : empty;
+            continue;
+        }
+
+        if (entry->data == data) {
+            return entry;
+        }
+
+        // in use, can't be evicted
+        if (entry->refs > 0 || entry->pinned) {
+            continue;
+        }
+
+        if (lru == NULL || (cache_tick - entry->last_used) > (cache_tick - lru->last_used)) {
+            lru = entry;
         }
     }
 
-    if (asset == NULL) {
-        logging(LOG_ERROR, "(%s, %d): not found", type, index);
-        return NULL;
+    if (empty != NULL) {
+        return empty;
+    }
+
+    if (lru != NULL) {
+        logging(LOG_DEBUG, "Evicting %s %p", cache->kind, lru->data);
+        cache->close(lru->handle);
+        *lru = (cache_entry_t){0};
+        return lru;
     }
 
-    logging(LOG_DEBUG, "(%s, %d): %p", type, index, asset->ptr);
-    return asset->ptr;
+    return NULL;
 }
 
-static const void *get_by_name(asset_kind_t kind, const char *name) {
-    const char *const type = asset_names[kind];
+static const void *cache_acquire(const cache_t *cache, const void *data) {
+    if (data == NULL) {
+        logging(LOG_ERROR, "%s: data == NULL", __func__);
+        return NULL;
+    }
+
+    cache_entry_t *const entry = cache_entry(cache, data);
+    if (entry == NULL) {
+        logging(LOG_ERROR, "%s: all %ss are in use", __func__, cache->kind);
+        return NULL;
+    }
 
-    const asset_t *asset = NULL;
-    for (size_t i = 0; i < total_count(); ++i) {
-        const asset_t *ptr = &assets[i];
-        if (ptr->kind == kind && (strcmp(ptr->name, name) == 0)) {
-            asset = ptr;
-            break;
+    if (entry->handle == NULL) {
+        entry->handle = cache->load(data);
+        if (entry->handle == NULL) {
+            logging(LOG_ERROR, "%s: could not load %s %p", __func__, cache->kind, data);
+            return NULL;
         }
+
+        entry->data = data;
     }
 
-    if (asset == NULL) {
-        logging(LOG_ERROR, "(%s, '%s'): not found", type, name);
+    if (entry->refs == UINT16_MAX) {
+        logging(LOG_ERROR, "%s: too many references to %s %p", __func__, cache->kind, data);
         return NULL;
     }
 
-    logging(LOG_DEBUG, "(%s, '%s'): %p", type, name, asset->ptr);
-    return asset->ptr;
+    entry->refs += 1;
+    entry->last_used = ++cache_tick;
+
+    return entry->handle;
 }
 
-//
+static cache_entry_t *cache_find(const cache_t *cache, const void *handle) {
+    for (size_t i = 0; i < cache->size; ++i) {
+        cache_entry_t *const entry = &cache->entries[i];
 
-void set_device_by_name(const char *name, painter_device_t device) {
-    set(DEVICE, name, device);
+        if (entry->handle == handle) {
+            return entry;
+        }
+    }
+
+    logging(LOG_ERROR, "%s: unknown %s handle %p", __func__, cache->kind, handle);
+    return NULL;
 }
 
-painter_device_t get_device_by_name(const char *name) {
-    return get_by_name(DEVICE, name);
+static void cache_pin(const cache_t *cache, const void *handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+    cache_entry_t *const entry = cache_find(cache, handle);
+    if (entry != NULL) {
+        entry->pinned = true;
+    }
 }
 
-size_t get_num_devices(void) {
-    return count.devices;
+static void cache_release(const cache_t *cache, const void *handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+    cache_entry_t *const entry = cache_find(cache, handle);
+    if (entry == NULL) {
+        return;
+    }
+
+    if (entry->refs == 0) {
+        logging(LOG_ERROR, "%s: %s %p was not acquired", __func__, cache->kind, entry->data);
+        return;
+    }
+
+    // not closed, will be reused (or evicted when room is needed)
+    entry->refs -= 1;
 }
 
-painter_device_t get_device_by_index(size_t index) {
-    return get_by_index(DEVICE, index);
+painter_font_handle_t acquire_font(const void *data) {
+    return cache_acquire(&font_cache, data);
+}
+
+void release_font(painter_font_handle_t font) {
+    cache_release(&font_cache, font);
+}
+
+void pin_font(painter_font_handle_t font) {
+    cache_pin(&font_cache, font);
+}
+
+painter_image_handle_t acquire_image(const void *data) {
+    return cache_acquire(&image_cache, data);
+}
+
+void release_image(painter_image_handle_t image) {
+    cache_release(&image_cache, image);
+}
+
+void pin_image(painter_image_handle_t image) {
+    cache_pin(&image_cache, image);
 }
 
 //
+// fonts and images: slot of each name is given by a perfect hash, computed at build time
+//
+
+// NOTE: must match `slot_hash` in `qp_resources.py`
+// a name that is not in the table may still land on a used slot, check the full hash to reject it
+static bool find_slot(const qp_asset_table_t *table, const char *name, size_t *slot) {
+    const uint32_t bucket = qp_asset_hash(0, name) % table->buckets;
+    const uint32_t hash   = qp_asset_hash(table->seeds[bucket], name);
+
+    *slot = hash % table->size;
+
+    return table->slots[*slot].name != NULL && table->slots[*slot].hash == hash;
+}
+
+static bool find_index(const qp_asset_table_t *table, size_t index, size_t *slot) {
+    if (index >= table->count) {
+        return false;
+    }
 
-void set_font_by_name(const char *name, const uint8_t *font) {
-    set(FONT, name, font);
+    *slot = table->order[index];
+    return true;
 }
 
+// reverse of find_index, only used to hand out ids so a linear search is fine
+static bool find_position(const qp_asset_table_t *table, const char *name, size_t *index) {
+    size_t slot;
+    if (!find_slot(table, name, &slot)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < table->count; ++i) {
+        if (table->order[i] == slot) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+
 painter_font_handle_t get_font_by_name(const char *name) {
-    return get_by_name(FONT, name);
+    size_t slot;
+    if (!find_slot(&qp_fonts_table, name, &slot)) {
+        logging(LOG_ERROR, "(font, '%s'): not found", name);
+        return NULL;
+    }
+
+    return acquire_font(qp_fonts_table.slots[slot].data);
+}
+
+bool get_font_index(const char *name, size_t *index) {
+    return find_position(&qp_fonts_table, name, index);
 }
 
 size_t get_num_fonts(void) {
-    return count.fonts;
+    return QP_NUM_FONTS;
 }
 
 painter_font_handle_t get_font_by_index(size_t index) {
-    return get_by_index(FONT, index);
+    size_t slot;
+    if (!find_index(&qp_fonts_table, index, &slot)) {
+        logging(LOG_ERROR, "(font, %d): not found", index);
+        return NULL;
+    }
+
+    return acquire_font(qp_fonts_table.slots[slot].data);
 }
 
 //
 
-void set_image_by_name(const char *name, const uint8_t *image) {
-    set(IMAGE, name, image);
+painter_image_handle_t get_image_by_name(const char *name) {
+    size_t slot;
+    if (!find_slot(&qp_images_table, name, &slot)) {
+        logging(LOG_ERROR, "(image, '%s'): not found", name);
+        return NULL;
+    }
+
+    return acquire_image(qp_images_table.slots[slot].data);
 }
 
-painter_image_handle_t get_image_by_name(const char *name) {
-    return get_by_name(IMAGE, name);
+bool get_image_index(const char *name, size_t *index) {
+    return find_position(&qp_images_table, name, index);
 }
 
 size_t get_num_images(void) {
-    return count.images;
+    return QP_NUM_IMAGES;
 }
 
 painter_image_handle_t get_image_by_index(size_t index) {
-    return get_by_index(IMAGE, index);
+    size_t slot;
+    if (!find_index(&qp_images_table, index, &slot)) {
+        logging(LOG_ERROR, "(image, %d): not found", index);
+        return NULL;
+    }
+
+    return acquire_image(qp_images_table.slots[slot].data);
 }
@@ -0,0 +1,284 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/display_list.h"
+
+#include <quantum/compiler_support.h>
+#include <quantum/quantum.h>
+#include <string.h>
+
+#include "elpekenin/qp/assets.h"
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+// devices that got drawn on are tracked on a bitmask
+STATIC_ASSERT(QP_ASSETS_SIZE <= 32, "Too many devices to track");
+
+static struct {
+    uint8_t buff[QP_DISPLAY_LIST_SIZE];
+    size_t  length;
+} list = {0};
+
+void qp_display_list_reset(void) {
+    list.length = 0;
+}
+
+bool qp_display_list_append(const uint8_t *data, size_t length) {
+    if (list.length + length > sizeof(list.buff)) {
+        logging(LOG_ERROR, "%s: list is full", __func__);
+        qp_display_list_reset();
+        return false;
+    }
+
+    memcpy(&list.buff[list.length], data, length);
+    list.length += length;
+
+    return true;
+}
+
+//
+// parsing
+//
+
+typedef struct {
+    const uint8_t *ptr;
+    const uint8_t *end;
+    bool           ok; // becomes false when reading past the end
+} reader_t;
+
+static const uint8_t *read_bytes(reader_t *reader, size_t n) {
+    if (!reader->ok || (size_t)(reader->end - reader->ptr) < n) {
+        reader->ok = false;
+        return NULL;
+    }
+
+    const uint8_t *ret = reader->ptr;
+    reader->ptr += n;
+    return ret;
+}
+
+static uint8_t read_u8(reader_t *reader) {
+    const uint8_t *ptr = read_bytes(reader, 1);
+    return ptr == NULL ? 0 : ptr[0];
+}
+
+static uint16_t read_u16(reader_t *reader) {
+    const uint8_t *ptr = read_bytes(reader, 2);
+    return ptr == NULL ? 0 : ptr[0] | (ptr[1] << 8);
+}
+
+static hsv_t read_hsv(reader_t *reader) {
+    const uint8_t h = read_u8(reader);
+    const uint8_t s = read_u8(reader);
+    const uint8_t v = read_u8(reader);
+    return (hsv_t){h, s, v};
+}
+
+// copy text into `text`, which has room for (at least) 256 chars
+static bool read_text(reader_t *reader, char *text) {
+    const uint8_t  length = read_u8(reader);
+    const uint8_t *ptr    = read_bytes(reader, length);
+    if (ptr == NULL) {
+        return false;
+    }
+
+    memcpy(text, ptr, length);
+    text[length] = '\0';
+    return true;
+}
+
+static painter_device_t read_device(reader_t *reader, uint32_t *touched) {
+    const uint8_t index = read_u8(reader);
+    if (!reader->ok) {
+        return NULL;
+    }
+
+    const painter_device_t device = get_device_by_index(index);
+    if (device != NULL) {
+        *touched |= 1ul << index;
+    }
+
+    return device;
+}
+
+//
+// execution
+//
+
+static bool run_one(reader_t *reader, uint32_t *touched) {
+    const qp_display_list_op_t op = read_u8(reader);
+
+    const painter_device_t device = read_device(reader, touched);
+    if (device == NULL) {
+        return false;
+    }
+
+    switch (op) {
+        case QP_DL_CLEAR:
+            return qp_clear(device);
+
+        case QP_DL_SETPIXEL: {
+            const uint16_t x   = read_u16(reader);
+            const uint16_t y   = read_u16(reader);
+            const hsv_t    hsv = read_hsv(reader);
+            return reader->ok && qp_setpixel(device, x, y, hsv.h, hsv.s, hsv.v);
+        }
+
+        case QP_DL_LINE: {
+            const uint16_t x0  = read_u16(reader);
+            const uint16_t y0  = read_u16(reader);
+            const uint16_t x1  = read_u16(reader);
+            const uint16_t y1  = read_u16(reader);
+            const hsv_t    hsv = read_hsv(reader);
+            return reader->ok && qp_line(device, x0, y0, x1, y1, hsv.h, hsv.s, hsv.v);
+        }
+
+        case QP_DL_RECT: {
+            const uint16_t left   = read_u16(reader);
+            const uint16_t top    = read_u16(reader);
+            const uint16_t right  = read_u16(reader);
+            const uint16_t bottom = read_u16(reader);
+            const hsv_t    hsv    = read_hsv(reader);
+            const bool     filled = read_u8(reader);
+            return reader->ok && qp_rect(device, left, top, right, bottom, hsv.h, hsv.s, hsv.v, filled);
+        }
+
+        case QP_DL_CIRCLE: {
+            const uint16_t x      = read_u16(reader);
+            const uint16_t y      = read_u16(reader);
+            const uint16_t radius = read_u16(reader);
+            const hsv_t    hsv    = read_hsv(reader);
+            const bool     filled = read_u8(reader);
+            return reader->ok && qp_circle(device, x, y, radius, hsv.h, hsv.s, hsv.v, filled);
+        }
+
+        case QP_DL_ELLIPSE: {
+            const uint16_t x      = read_u16(reader);
+            const uint16_t y      = read_u16(reader);
+            const uint16_t sizex  = read_u16(reader);
+            const uint16_t sizey  = read_u16(reader);
+            const hsv_t    hsv    = read_hsv(reader);
+            const bool     filled = read_u8(reader);
+            return reader->ok && qp_ellipse(device, x, y, sizex, sizey, hsv.h, hsv.s, hsv.v, filled);
+        }
+
+        case QP_DL_DRAWIMAGE:
+        case QP_DL_DRAWIMAGE_RECOLOR: {
+            const uint8_t  index = read_u8(reader);
+            const uint16_t x     = read_u16(reader);
+            const uint16_t y     = read_u16(reader);
+
+            hsv_t fg = {0};
+            hsv_t bg = {0};
+            if (op == QP_DL_DRAWIMAGE_RECOLOR) {
+                fg = read_hsv(reader);
+                bg = read_hsv(reader);
+            }
+
+            if (!reader->ok) {
+                return false;
+            }
+
+            const painter_image_handle_t image = get_image_by_index(index);
+            if (image == NULL) {
+                return false;
+            }
+
+            const bool ret = op == QP_DL_DRAWIMAGE ? qp_drawimage(device, x, y, image) : qp_drawimage_recolor(device, x, y, image, fg.h, fg.s, fg.v, bg.h, bg.s, bg.v);
+
+            release_image(image);
+            return ret;
+        }
+
+        case QP_DL_DRAWTEXT:
+        case QP_DL_DRAWTEXT_RECOLOR: {
+            const uint8_t  index = read_u8(reader);
+            const uint16_t x     = read_u16(reader);
+            const uint16_t y     = read_u16(reader);
+
+            hsv_t fg = {0};
+            hsv_t bg = {0};
+            if (op == QP_DL_DRAWTEXT_RECOLOR) {
+                fg = read_hsv(reader);
+                bg = read_hsv(reader);
+            }
+
+            char text[UINT8_MAX + 1];
+            if (!read_text(reader, text)) {
+                return false;
+            }
+
+            const painter_font_handle_t font = get_font_by_index(index);
+            if (font == NULL) {
+                return false;
+            }
+
+            // qp_drawtext returns the width drawn, not a status
+            if (op == QP_DL_DRAWTEXT) {
+                qp_drawtext(device, x, y, font, text);
+            } else {
+                qp_drawtext_recolor(device, x, y, font, text, fg.h, fg.s, fg.v, bg.h, bg.s, bg.v);
+            }
+
+            release_font(font);
+            return true;
+        }
+
+        case QP_DL_VIEWPORT: {
+            const uint16_t left   = read_u16(reader);
+            const uint16_t top    = read_u16(reader);
+            const uint16_t right  = read_u16(reader);
+            const uint16_t bottom = read_u16(reader);
+            return reader->ok && qp_viewport(device, left, top, right, bottom);
+        }
+
+        case QP_DL_PIXDATA: {
+            const uint8_t  n_pixels = read_u8(reader);
+            const uint8_t *pixels   = read_bytes(reader, n_pixels * sizeof(uint16_t));
+            return pixels != NULL && qp_pixdata(device, pixels, n_pixels);
+        }
+
+        case QP_DL_FLUSH:
+            return qp_flush(device);
+
+        default:
+            logging(LOG_ERROR, "%s: unknown opcode %d", __func__, op);
+            return false;
+    }
+}
+
+bool qp_display_list_execute(bool flush, uint16_t *executed) {
+    reader_t reader = {
+        .ptr = list.buff,
+        .end = list.buff + list.length,
+        .ok  = true,
+    };
+
+    uint32_t touched = 0;
+    bool     ret     = true;
+
+    *executed = 0;
+
+    while (reader.ptr < reader.end) {
+        if (!run_one(&reader, &touched)) {
+            logging(LOG_ERROR, "%s: command #%d (offset %d) failed", __func__, *executed, reader.ptr - list.buff);
+            ret = false;
+            break;
+        }
+
+        *executed += 1;
+    }
+
+    if (flush) {
+        for (uint8_t i = 0; i < QP_ASSETS_SIZE; ++i) {
+            if (touched & (1ul << i)) {
+                qp_flush(get_device_by_index(i));
+            }
+        }
+    }
+
+    qp_display_list_reset();
+
+    return ret;
+}
@@ -0,0 +1,223 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/eink.h"
+
+#include <drivers/painter/eink_panel/qp_eink_panel.h>
+#include <quantum/compiler_support.h>
+#include <quantum/painter/qp_comms.h>
+#include <quantum/quantum.h>
+#include <string.h>
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+// partial update commands, same planes as their full counterparts (DTM1 = 0x10, DTM2 = 0x13) but for a window
+#define PDTM1 0x14 // black/white plane
+#define PDTM2 0x15 // red plane
+#define PDRF 0x16  // refresh window
+
+// the vtable installed on the device lives inside the state, use it to get back to the latter
+static qp_eink_diff_t *get_eink(painter_device_t device) {
+    const painter_driver_t *driver = (const painter_driver_t *)device;
+    return (qp_eink_diff_t *)((uint8_t *)driver->driver_vtable - offsetof(qp_eink_diff_t, vtable));
+}
+
+static inline size_t stride(const qp_eink_diff_t *eink) {
+    return eink->width / 8;
+}
+
+static inline size_t plane_size(const qp_eink_diff_t *eink) {
+    return stride(eink) * eink->height;
+}
+
+//
+// diffing
+//
+
+typedef struct {
+    uint16_t left; // bytes
+    uint16_t top;
+    uint16_t right; // bytes
+    uint16_t bottom;
+} region_t;
+
+// bounding box of the bytes that changed on the black plane, returns whether anything did
+static bool find_changes(const qp_eink_diff_t *eink, region_t *region) {
+    bool changed = false;
+
+    *region = (region_t){
+        .left = UINT16_MAX,
+        .top  = UINT16_MAX,
+    };
+
+    for (uint16_t y = 0; y < eink->height; ++y) {
+        for (uint16_t x = 0; x < stride(eink); ++x) {
+            const size_t index = (y * stride(eink)) + x;
+
+            if (eink->buffer[index] == eink->previous[index]) {
+                continue;
+            }
+
+            changed        = true;
+            region->left   = MIN(region->left, x);
+            region->right  = MAX(region->right, x);
+            region->top    = MIN(region->top, y);
+            region->bottom = MAX(region->bottom, y);
+        }
+    }
+
+    return changed;
+}
+
+static inline bool red_changed(const qp_eink_diff_t *eink) {
+    return memcmp(eink->buffer + plane_size(eink), eink->previous + plane_size(eink), plane_size(eink)) != 0;
+}
+
+//
+// flushing
+//
+
+static void send_area(painter_device_t device, const region_t *region) {
+    const uint16_t x = region->left * 8;
+    const uint16_t y = region->top;
+    const uint16_t w = (region->right - region->left + 1) * 8;
+    const uint16_t h = region->bottom - region->top + 1;
+
+    const uint8_t area[] = {x >> 8, x & 0xF8, y >> 8, y & 0xFF, w >> 8, w & 0xF8, h >> 8, h & 0xFF};
+    qp_comms_send(device, area, sizeof(area));
+}
+
+static void send_rows(const qp_eink_diff_t *eink, painter_device_t device, const uint8_t *plane, const region_t *region) {
+    const uint16_t width = region->right - region->left + 1;
+
+    for (uint16_t y = region->top; y <= region->bottom; ++y) {
+        qp_comms_send(device, &plane[(y * stride(eink)) + region->left], width);
+    }
+}
+
+// controller can't take commands while refreshing, and refreshing too often may damage the panel
+static bool can_refresh(const qp_eink_diff_t *eink) {
+    return !eink->refreshed || timer_elapsed32(eink->last_refresh) >= QP_EINK_MIN_REFRESH_INTERVAL;
+}
+
+static bool partial_flush(qp_eink_diff_t *eink, painter_device_t device, const region_t *region) {
+    // full refreshes are rate limited by the driver itself, follow its lead
+    const eink_panel_dc_reset_painter_device_t *panel = (const eink_panel_dc_reset_painter_device_t *)device;
+    if (!panel->can_flush) {
+        logging(LOG_WARN, "%s: driver is cooling down", __func__);
+        return false;
+    }
+
+    if (!qp_comms_start(device)) {
+        return false;
+    }
+
+    // both planes of the window are written, red did not change (see eink_flush) but must be sent along
+    qp_comms_command(device, PDTM1);
+    send_area(device, region);
+    send_rows(eink, device, eink->buffer, region);
+
+    qp_comms_command(device, PDTM2);
+    send_area(device, region);
+    send_rows(eink, device, eink->buffer + plane_size(eink), region);
+
+    qp_comms_command(device, PDRF);
+    send_area(device, region);
+
+    qp_comms_stop(device);
+
+    return true;
+}
+
+static bool eink_flush(painter_device_t device) {
+    qp_eink_diff_t *eink = get_eink(device);
+
+    region_t   region;
+    const bool black = find_changes(eink, &region);
+    const bool red   = red_changed(eink);
+
+    // already up to date
+    if (eink->synced && !black && !red) {
+        qp_eink_diff_flushed(device);
+        return true;
+    }
+
+    if (!can_refresh(eink)) {
+        logging(LOG_WARN, "%s: panel may still be busy", __func__);
+        return false;
+    }
+
+    // red plane can't be partially refreshed
+    const bool full = !eink->synced || red || eink->partials >= QP_EINK_FULL_REFRESH_INTERVAL;
+
+    if (full) {
+        if (!eink->inner->flush(device)) {
+            return false;
+        }
+
+        eink->partials = 0;
+    } else {
+        if (!partial_flush(eink, device, &region)) {
+            logging(LOG_ERROR, "%s: partial refresh failed", __func__);
+            return false;
+        }
+
+        eink->partials += 1;
+    }
+
+    memcpy(eink->previous, eink->buffer, 2 * plane_size(eink));
+    eink->synced       = true;
+    eink->refreshed    = true;
+    eink->last_refresh = timer_read32();
+
+    qp_eink_diff_flushed(device);
+
+    return true;
+}
+
+bool qp_eink_diff_mark_synced(painter_device_t device) {
+    const painter_driver_t *driver = (const painter_driver_t *)device;
+    if (driver == NULL || driver->driver_vtable->flush != eink_flush) {
+        logging(LOG_ERROR, "%s: not an eink_diff device", __func__);
+        return false;
+    }
+
+    qp_eink_diff_t *eink = get_eink(device);
+
+    memcpy(eink->previous, eink->buffer, 2 * plane_size(eink));
+    eink->synced = true;
+
+    return true;
+}
+
+__weak_symbol void qp_eink_diff_flushed(__unused painter_device_t device) {}
+
+//
+// setup
+//
+
+bool qp_eink_diff_init(qp_eink_diff_t *eink, painter_device_t device, uint16_t width, uint16_t height, const void *buffer, void *previous) {
+    if (device == NULL) {
+        logging(LOG_ERROR, "%s: device == NULL", __func__);
+        return false;
+    }
+
+    *eink = (qp_eink_diff_t){
+        .buffer   = buffer,
+        .previous = previous,
+        .width    = width,
+        .height   = height,
+    };
+
+    // hook into the device
+    painter_driver_t *driver = (painter_driver_t *)device;
+
+    eink->inner        = driver->driver_vtable;
+    eink->vtable       = *driver->driver_vtable;
+    eink->vtable.flush = eink_flush;
+
+    driver->driver_vtable = &eink->vtable;
+
+    return true;
+}
@@ -0,0 +1,352 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/framebuffer.h"
+
+#include <quantum/compiler_support.h>
+#include <quantum/quantum.h>
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+// the vtable installed on the surface lives inside the framebuffer, use it to get back to the latter
+static qp_framebuffer_t *get_framebuffer(painter_device_t device) {
+    const painter_driver_t *driver = (const painter_driver_t *)device;
+    return (qp_framebuffer_t *)((uint8_t *)driver->driver_vtable - offsetof(qp_framebuffer_t, vtable));
+}
+
+//
+// dirty tracking
+//
+
+static inline uint16_t tiles_x(const qp_framebuffer_t *framebuffer) {
+    return QP_FRAMEBUFFER_TILES(framebuffer->width);
+}
+
+static inline uint16_t tiles_y(const qp_framebuffer_t *framebuffer) {
+    return QP_FRAMEBUFFER_TILES(framebuffer->height);
+}
+
+static inline size_t tile_index(const qp_framebuffer_t *framebuffer, uint16_t tx, uint16_t ty) {
+    return (ty * tiles_x(framebuffer)) + tx;
+}
+
+static inline bool is_dirty(const qp_framebuffer_t *framebuffer, uint16_t tx, uint16_t ty) {
+    const size_t index = tile_index(framebuffer, tx, ty);
+    return (framebuffer->dirty[index / 8] >> (index % 8)) & 1;
+}
+
+static inline void set_dirty(qp_framebuffer_t *framebuffer, uint16_t tx, uint16_t ty, bool dirty) {
+    const size_t index = tile_index(framebuffer, tx, ty);
+
+    if (dirty) {
+        framebuffer->dirty[index / 8] |= (1 << (index % 8));
+    } else {
+        framebuffer->dirty[index / 8] &= ~(1 << (index % 8));
+    }
+}
+
+static void mark_all(qp_framebuffer_t *framebuffer) {
+    memset(framebuffer->dirty, 0xFF, QP_FRAMEBUFFER_DIRTY_BYTES(framebuffer->width, framebuffer->height));
+}
+
+//
+// wrappers around surface's vtable
+//
+
+static bool framebuffer_clear(painter_device_t device) {
+    qp_framebuffer_t *framebuffer = get_framebuffer(device);
+
+    mark_all(framebuffer);
+
+    return framebuffer->inner->clear(device);
+}
+
+static bool framebuffer_viewport(painter_device_t device, uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) {
+    qp_framebuffer_t *framebuffer = get_framebuffer(device);
+
+    framebuffer->cursor.left   = left;
+    framebuffer->cursor.top    = top;
+    framebuffer->cursor.right  = right;
+    framebuffer->cursor.bottom = bottom;
+    framebuffer->cursor.x      = left;
+    framebuffer->cursor.y      = top;
+
+    return framebuffer->inner->viewport(device, left, top, right, bottom);
+}
+
+static bool framebuffer_pixdata(painter_device_t device, const void *pixel_data, uint32_t native_pixel_count) {
+    qp_framebuffer_t *framebuffer = get_framebuffer(device);
+
+    const uint16_t *pixels = (const uint16_t *)pixel_data;
+
+    // only flag tiles where a pixel actually changes, surface will perform the write itself
+    for (uint32_t i = 0; i < native_pixel_count; ++i) {
+        const uint16_t x = framebuffer->cursor.x;
+        const uint16_t y = framebuffer->cursor.y;
+
+        if (x < framebuffer->width && y < framebuffer->height && framebuffer->buffer[(y * framebuffer->width) + x] != pixels[i]) {
+            set_dirty(framebuffer, x / QP_FRAMEBUFFER_TILE_SIZE, y / QP_FRAMEBUFFER_TILE_SIZE, true);
+        }
+
+        // same logic as the surface's viewport
+        framebuffer->cursor.x += 1;
+        if (framebuffer->cursor.x > framebuffer->cursor.right) {
+            framebuffer->cursor.x = framebuffer->cursor.left;
+            framebuffer->cursor.y += 1;
+        }
+
+        if (framebuffer->cursor.y > framebuffer->cursor.bottom) {
+            framebuffer->cursor.y = framebuffer->cursor.top;
+        }
+    }
+
+    return framebuffer->inner->pixdata(device, pixel_data, native_pixel_count);
+}
+
+//
+// flushing
+//
+
+// find the next dirty region and store it as pending, clearing its tiles
+static bool next_rect(qp_framebuffer_t *framebuffer) {
+    for (uint16_t ty = 0; ty < tiles_y(framebuffer); ++ty) {
+        uint16_t tx = 0;
+
+        while (tx < tiles_x(framebuffer) && !is_dirty(framebuffer, tx, ty)) {
+            tx += 1;
+        }
+
+        if (tx == tiles_x(framebuffer)) {
+            continue;
+        }
+
+        // horizontal run of dirty tiles
+        const uint16_t start = tx;
+        while (tx < tiles_x(framebuffer) && is_dirty(framebuffer, tx, ty)) {
+            set_dirty(framebuffer, tx, ty, false);
+            tx += 1;
+        }
+        const uint16_t end = tx - 1;
+
+        // grow it downwards while rows below are dirty on the same span
+        uint16_t bottom = ty;
+        while (bottom + 1 < tiles_y(framebuffer)) {
+            bool full = true;
+            for (uint16_t i = start; i <= end; ++i) {
+                if (!is_dirty(framebuffer, i, bottom + 1)) {
+                    full = false;
+                    break;
+                }
+            }
+
+            if (!full) {
+                break;
+            }
+
+            bottom += 1;
+            for (uint16_t i = start; i <= end; ++i) {
+                set_dirty(framebuffer, i, bottom, false);
+            }
+        }
+
+        framebuffer->pending.active = true;
+        framebuffer->pending.left   = start * QP_FRAMEBUFFER_TILE_SIZE;
+        framebuffer->pending.right  = MIN((end + 1) * QP_FRAMEBUFFER_TILE_SIZE, framebuffer->width) - 1;
+        framebuffer->pending.row    = ty * QP_FRAMEBUFFER_TILE_SIZE;
+        framebuffer->pending.bottom = MIN((bottom + 1) * QP_FRAMEBUFFER_TILE_SIZE, framebuffer->height) - 1;
+
+        return true;
+    }
+
+    return false;
+}
+
+// send the next `rows` rows of the pending region
+static uint32_t flush_rows(qp_framebuffer_t *framebuffer, uint16_t rows) {
+    const uint16_t left   = framebuffer->pending.left;
+    const uint16_t right  = framebuffer->pending.right;
+    const uint16_t top    = framebuffer->pending.row;
+    const uint16_t bottom = top + rows - 1;
+
+    // another device may have used the bus in between slices, set the window again
+    if (!qp_viewport(framebuffer->target, left, top, right, bottom)) {
+        goto err;
+    }
+
+    // rows of the rectangle are not contiguous in the buffer, send them one by one
+    const uint16_t width = right - left + 1;
+    for (uint16_t y = top; y <= bottom; ++y) {
+        if (!qp_pixdata(framebuffer->target, &framebuffer->buffer[(y * framebuffer->width) + left], width)) {
+            goto err;
+        }
+    }
+
+    framebuffer->pending.row    = bottom + 1;
+    framebuffer->pending.active = framebuffer->pending.row <= framebuffer->pending.bottom;
+
+    return width * (bottom - top + 1);
+
+err:
+    // drop the region, instead of retrying it forever
+    logging(LOG_ERROR, "%s: could not send data", __func__);
+    framebuffer->pending.active = false;
+    return 0;
+}
+
+bool qp_framebuffer_is_dirty(const qp_framebuffer_t *framebuffer) {
+    if (framebuffer->pending.active) {
+        return true;
+    }
+
+    for (size_t i = 0; i < QP_FRAMEBUFFER_DIRTY_BYTES(framebuffer->width, framebuffer->height); ++i) {
+        if (framebuffer->dirty[i] != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t qp_framebuffer_flush_slice(qp_framebuffer_t *framebuffer, uint32_t max_pixels) {
+    uint32_t sent = 0;
+
+    while (sent < max_pixels) {
+        if (!framebuffer->pending.active && !next_rect(framebuffer)) {
+            break;
+        }
+
+        // at least one row, to make progress on regions wider than the budget
+        const uint16_t width     = framebuffer->pending.right - framebuffer->pending.left + 1;
+        const uint16_t remaining = framebuffer->pending.bottom - framebuffer->pending.row + 1;
+        const uint16_t rows      = MAX(1, MIN(remaining, (max_pixels - sent) / width));
+
+        const uint32_t pixels = flush_rows(framebuffer, rows);
+        if (pixels == 0) {
+            break;
+        }
+
+        sent += pixels;
+    }
+
+    return sent;
+}
+
+bool qp_framebuffer_flush(qp_framebuffer_t *framebuffer) {
+    while (qp_framebuffer_is_dirty(framebuffer)) {
+        if (qp_framebuffer_flush_slice(framebuffer, UINT32_MAX) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// scheduling
+//
+
+static struct {
+    qp_framebuffer_t *framebuffers[QUANTUM_PAINTER_NUM_DISPLAYS];
+    uint8_t           count;
+    uint8_t           next;
+} scheduler = {0};
+
+bool qp_framebuffer_schedule(qp_framebuffer_t *framebuffer) {
+    if (scheduler.count == ARRAY_SIZE(scheduler.framebuffers)) {
+        logging(LOG_ERROR, "%s: no space left", __func__);
+        return false;
+    }
+
+    scheduler.framebuffers[scheduler.count++] = framebuffer;
+    return true;
+}
+
+void qp_framebuffer_unschedule(qp_framebuffer_t *framebuffer) {
+    for (uint8_t i = 0; i < scheduler.count; ++i) {
+        if (scheduler.framebuffers[i] != framebuffer) {
+            continue;
+        }
+
+        memmove(&scheduler.framebuffers[i], &scheduler.framebuffers[i + 1], sizeof(scheduler.framebuffers[0]) * (scheduler.count - i - 1));
+        scheduler.count -= 1;
+
+        if (scheduler.next >= scheduler.count) {
+            scheduler.next = 0;
+        }
+
+        return;
+    }
+}
+
+void qp_framebuffer_task(void) {
+    uint32_t budget = QP_FRAMEBUFFER_FRAME_BUDGET;
+    uint8_t  idle   = 0;
+
+    // round-robin, one slice at a time, until budget runs out or nothing is left to send
+    // next frame starts where this one stopped, so that a big flush can't starve other displays
+    while (budget > 0 && idle < scheduler.count) {
+        qp_framebuffer_t *const framebuffer = scheduler.framebuffers[scheduler.next];
+        scheduler.next                      = (scheduler.next + 1) % scheduler.count;
+
+        const uint32_t sent = qp_framebuffer_flush_slice(framebuffer, MIN(budget, QP_FRAMEBUFFER_SLICE_SIZE));
+        if (sent == 0) {
+            idle += 1;
+            continue;
+        }
+
+        idle   = 0;
+        budget = (sent >= budget) ? 0 : budget - sent;
+    }
+}
+
+//
+// setup
+//
+
+painter_device_t qp_framebuffer_target(painter_device_t device) {
+    const painter_driver_t *driver = (const painter_driver_t *)device;
+    if (driver == NULL || driver->driver_vtable->pixdata != framebuffer_pixdata) {
+        return device;
+    }
+
+    return get_framebuffer(device)->target;
+}
+
+painter_device_t qp_framebuffer_init(qp_framebuffer_t *framebuffer, painter_device_t target, uint16_t width, uint16_t height, void *buffer, uint8_t *dirty) {
+    const painter_device_t surface = qp_rgb565_make_surface(width, height, buffer);
+    if (surface == NULL) {
+        logging(LOG_ERROR, "%s: could not create surface", __func__);
+        return NULL;
+    }
+
+    if (!qp_init(surface, QP_ROTATION_0)) {
+        logging(LOG_ERROR, "%s: could not init surface", __func__);
+        return NULL;
+    }
+
+    *framebuffer = (qp_framebuffer_t){
+        .target  = target,
+        .surface = surface,
+        .buffer  = buffer,
+        .dirty   = dirty,
+        .width   = width,
+        .height  = height,
+    };
+
+    // hook into the surface
+    painter_driver_t *driver = (painter_driver_t *)surface;
+
+    framebuffer->inner           = driver->driver_vtable;
+    framebuffer->vtable          = *driver->driver_vtable;
+    framebuffer->vtable.clear    = framebuffer_clear;
+    framebuffer->vtable.viewport = framebuffer_viewport;
+    framebuffer->vtable.pixdata  = framebuffer_pixdata;
+
+    driver->driver_vtable = &framebuffer->vtable;
+
+    // buffer contents are unknown, flush everything on first call
+    mark_all(framebuffer);
+
+    return surface;
+}
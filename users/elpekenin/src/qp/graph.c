@@ -0,0 +1,156 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/graph.h"
+
+#include <quantum/quantum.h>
+
+// area where lines are drawn, axes excluded
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} plot_t;
+
+void graph_reset(graph_t *graph) {
+    graph->committed = 0;
+    graph->drawn     = 0;
+    graph->samples   = 0;
+    graph->dirty     = true;
+}
+
+void graph_invalidate(graph_t *graph) {
+    graph->dirty = true;
+}
+
+void graph_push(graph_t *graph, const uint8_t *values) {
+    for (size_t i = 0; i < graph->n_series; ++i) {
+        graph_column_t *current = &graph->series[i].current;
+        const uint8_t   value   = values[i];
+
+        if (graph->samples == 0) {
+            *current = (graph_column_t){
+                .min  = value,
+                .max  = value,
+                .last = value,
+            };
+            continue;
+        }
+
+        current->min  = MIN(current->min, value);
+        current->max  = MAX(current->max, value);
+        current->last = value;
+    }
+
+    graph->samples += 1;
+    if (graph->samples < MAX(graph->samples_per_column, 1)) {
+        return;
+    }
+
+    for (size_t i = 0; i < graph->n_series; ++i) {
+        graph->series[i].history[graph->committed % graph->columns] = graph->series[i].current;
+    }
+
+    graph->committed += 1;
+    graph->samples = 0;
+}
+
+//
+// drawing
+//
+
+static uint16_t column_x(const graph_t *graph, const plot_t *plot, size_t column) {
+    return plot->x + (uint32_t)column * plot->width / graph->columns;
+}
+
+static uint16_t value_y(const plot_t *plot, const graph_series_t *series, uint8_t value) {
+    const uint8_t max_value = MAX(series->max_value, 1);
+    value                   = MIN(value, max_value);
+
+    return plot->y + (plot->height - 1) - (uint32_t)value * (plot->height - 1) / max_value;
+}
+
+static void erase_column(const graph_t *graph, painter_device_t device, const plot_t *plot, size_t position) {
+    const uint16_t left  = column_x(graph, plot, position);
+    const uint16_t right = column_x(graph, plot, position + 1) - 1;
+
+    if (right < left) {
+        return;
+    }
+
+    qp_rect(device, left, plot->y, right, plot->y + plot->height - 1, graph->background.h, graph->background.s, graph->background.v, true);
+}
+
+// `connect`: whether to join the line with the previous column
+static void draw_column(const graph_t *graph, painter_device_t device, const plot_t *plot, size_t column, bool connect) {
+    const size_t   position = column % graph->columns;
+    const uint16_t x        = column_x(graph, plot, position);
+
+    erase_column(graph, device, plot, position);
+
+    // wrapped around, lines would cross the whole graph
+    connect &= position != 0;
+
+    for (size_t i = 0; i < graph->n_series; ++i) {
+        const graph_series_t *series = &graph->series[i];
+        const graph_column_t *value  = &series->history[position];
+        const hsv_t           color  = series->color;
+
+        qp_line(device, x, value_y(plot, series, value->min), x, value_y(plot, series, value->max), color.h, color.s, color.v);
+
+        if (connect) {
+            const graph_column_t *prev   = &series->history[(column - 1) % graph->columns];
+            const uint16_t        prev_x = column_x(graph, plot, position - 1);
+
+            qp_line(device, prev_x, value_y(plot, series, prev->last), x, value_y(plot, series, value->last), color.h, color.s, color.v);
+        }
+    }
+}
+
+bool graph_render(graph_t *graph, painter_device_t device, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    if (graph->columns == 0 || width < 2 || height < 2) {
+        return false;
+    }
+
+    // 1px for the axes
+    const plot_t plot = {
+        .x      = x + 1,
+        .y      = y,
+        .width  = width - 1,
+        .height = height - 1,
+    };
+
+    // older columns were overwritten, can't draw incrementally
+    if (graph->committed - graph->drawn >= graph->columns) {
+        graph->dirty = true;
+    }
+
+    bool connect = true;
+
+    if (graph->dirty) {
+        const hsv_t bg   = graph->background;
+        const hsv_t axis = graph->axis;
+
+        qp_rect(device, x, y, x + width - 1, y + height - 1, bg.h, bg.s, bg.v, true);
+        qp_line(device, x, y, x, y + height - 1, axis.h, axis.s, axis.v);
+        qp_line(device, x, y + height - 1, x + width - 1, y + height - 1, axis.h, axis.s, axis.v);
+
+        // one column is kept empty, as the cursor
+        graph->drawn = graph->committed > graph->columns - 1 ? graph->committed - (graph->columns - 1) : 0;
+        graph->dirty = false;
+        connect      = false;
+    } else if (graph->drawn == graph->committed) {
+        return false;
+    }
+
+    for (; graph->drawn < graph->committed; ++graph->drawn) {
+        draw_column(graph, device, &plot, graph->drawn, connect && graph->drawn > 0);
+        connect = true;
+    }
+
+    // clear what comes next, so that new and old data don't get mixed
+    erase_column(graph, device, &plot, graph->committed % graph->columns);
+
+    return true;
+}
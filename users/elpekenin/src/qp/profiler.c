@@ -0,0 +1,236 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/profiler.h"
+
+#include <ch.h>
+#include <quantum/quantum.h>
+
+#include "elpekenin/qp/assets.h"
+
+#if IS_ENABLED(QP_FRAMEBUFFER)
+#    include "elpekenin/qp/framebuffer.h"
+#endif
+
+typedef struct {
+    painter_device_t           device;
+    qp_profiler_device_stats_t stats;
+} device_slot_t;
+
+static device_slot_t devices[QUANTUM_PAINTER_NUM_DISPLAYS] = {0};
+
+uint32_t qp_profiler_now(void) {
+    return (uint32_t)TIME_I2US(chVTGetSystemTimeX());
+}
+
+// find the slot of a device, assigning a new one the first time it is seen
+static qp_profiler_device_stats_t *get_device_stats(painter_device_t device) {
+    for (size_t i = 0; i < ARRAY_SIZE(devices); ++i) {
+        device_slot_t *const slot = &devices[i];
+
+        if (slot->device == device) {
+            return &slot->stats;
+        }
+
+        if (slot->device == NULL) {
+            slot->device = device;
+            return &slot->stats;
+        }
+    }
+
+    return NULL;
+}
+
+bool qp_profiler_get_device_stats(uint8_t index, painter_device_t *device, qp_profiler_device_stats_t *stats) {
+    if (index >= ARRAY_SIZE(devices) || devices[index].device == NULL) {
+        return false;
+    }
+
+    *device = devices[index].device;
+    *stats  = devices[index].stats;
+    return true;
+}
+
+bool qp_profiler_device_index(painter_device_t device, size_t *index) {
+    for (size_t i = 0; i < get_num_devices(); ++i) {
+        painter_device_t entry = get_device_by_index(i);
+
+        // comms report the panel, while the registry may hold a framebuffer drawing on it
+#if IS_ENABLED(QP_FRAMEBUFFER)
+        entry = qp_framebuffer_target(entry);
+#endif
+
+        if (entry == device) {
+            *index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// ui nodes
+//
+#if CM_ENABLED(UI)
+#    include "elpekenin/string.h"
+#    include "elpekenin/ui/utils.h"
+
+typedef struct {
+    const ui_node_t         *node;
+    qp_profiler_node_stats_t stats;
+} node_slot_t;
+
+static node_slot_t nodes[QP_PROFILER_NODES] = {0};
+
+static struct {
+    qp_profiler_node_stats_t *stats;
+    uint32_t                  start;
+} current = {0};
+
+static qp_profiler_node_stats_t *get_node_stats(const ui_node_t *node) {
+    for (size_t i = 0; i < ARRAY_SIZE(nodes); ++i) {
+        node_slot_t *const slot = &nodes[i];
+
+        if (slot->node == node) {
+            return &slot->stats;
+        }
+
+        if (slot->node == NULL) {
+            slot->node = node;
+            return &slot->stats;
+        }
+    }
+
+    return NULL;
+}
+
+void qp_profiler_node_begin(const ui_node_t *node) {
+    current.stats = get_node_stats(node);
+    current.start = qp_profiler_now();
+}
+
+void qp_profiler_node_end(void) {
+    if (current.stats != NULL) {
+        current.stats->renders += 1;
+        current.stats->render_time += qp_profiler_now() - current.start;
+    }
+
+    current.stats = NULL;
+}
+
+bool qp_profiler_get_node_stats(uint8_t index, const ui_node_t **node, qp_profiler_node_stats_t *stats) {
+    if (index >= ARRAY_SIZE(nodes) || nodes[index].node == NULL) {
+        return false;
+    }
+
+    *node  = nodes[index].node;
+    *stats = nodes[index].stats;
+    return true;
+}
+
+bool qp_profiler_init(ui_node_t *self) {
+    return ui_font_fits(self);
+}
+
+// counters may have been reset after the last draw
+static inline uint32_t delta(uint32_t now, uint32_t before) {
+    return (now >= before) ? (now - before) : now;
+}
+
+ui_time_t qp_profiler_render(const ui_node_t *self, painter_device_t display) {
+    qp_profiler_args_t *args = self->args;
+
+    const painter_font_handle_t font = acquire_font(args->font);
+    if (font == NULL) {
+        goto exit;
+    }
+
+    const uint32_t elapsed = MAX(1, timer_elapsed32(args->last_time));
+
+    // clear
+    qp_rect(display, self->start.x, self->start.y, self->start.x + self->size.x, self->start.y + self->size.y, HSV_BLACK, true);
+
+    // one line per device, with its traffic since last draw
+    // as elapsed time is in ms: bytes/ms == kB/s and us/ms == ms/s
+    for (size_t i = 0; i < ARRAY_SIZE(devices); ++i) {
+        const device_slot_t *const slot = &devices[i];
+        if (slot->device == NULL) {
+            break;
+        }
+
+        const uint16_t y = self->start.y + (i * font->line_height);
+
+        // can't fit more lines
+        if ((y + font->line_height) > (self->start.y + self->size.y)) {
+            break;
+        }
+
+        qp_profiler_device_stats_t *const last = &args->last[i];
+
+        const int kbytes    = delta(slot->stats.bytes, last->bytes) / elapsed;
+        const int commands  = (delta(slot->stats.commands, last->commands) * 1000) / elapsed;
+        const int send_time = delta(slot->stats.send_time, last->send_time) / elapsed;
+
+        *last = slot->stats;
+
+        size_t      index;
+        const char *name = qp_profiler_device_index(slot->device, &index) ? get_device_name(index) : "?";
+
+        char     buff[48];
+        string_t str = str_from_buffer(buff);
+        str_printf(&str, "%s %dkB/s %dcmd/s %dms/s", name, kbytes, commands, send_time);
+
+        if (!ui_text_fits(self, font, str.ptr)) {
+            continue;
+        }
+
+        qp_drawtext_recolor(display, self->start.x, y, font, str.ptr, HSV_WHITE, HSV_BLACK);
+    }
+
+    release_font(font);
+
+    args->last_time = timer_read32();
+
+exit:
+    return (ui_time_t)UI_MILLISECONDS(QP_PROFILER_UI_REDRAW_INTERVAL);
+}
+#endif
+
+//
+// comms hooks
+//
+
+void qp_profiler_on_send(painter_device_t device, uint32_t bytes, uint32_t time) {
+    qp_profiler_device_stats_t *const stats = get_device_stats(device);
+    if (stats != NULL) {
+        stats->bytes += bytes;
+        stats->send_time += time;
+    }
+}
+
+void qp_profiler_on_command(painter_device_t device) {
+    qp_profiler_device_stats_t *const stats = get_device_stats(device);
+    if (stats != NULL) {
+        stats->commands += 1;
+    }
+}
+
+void qp_profiler_on_cs_toggle(painter_device_t device) {
+    qp_profiler_device_stats_t *const stats = get_device_stats(device);
+    if (stats != NULL) {
+        stats->cs_toggles += 1;
+    }
+}
+
+void qp_profiler_reset(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(devices); ++i) {
+        devices[i].stats = (qp_profiler_device_stats_t){0};
+    }
+
+#if CM_ENABLED(UI)
+    for (size_t i = 0; i < ARRAY_SIZE(nodes); ++i) {
+        nodes[i].stats = (qp_profiler_node_stats_t){0};
+    }
+#endif
+}
@@ -12,9 +12,49 @@
 #    include "elpekenin/spi_custom.h"
 #    include "qp_comms_spi.h"
 
+#    if IS_ENABLED(QP_PROFILER)
+#        include "elpekenin/qp/profiler.h"
+#    endif
+
+#    include <string.h>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Base SPI support
 
+#    ifndef SIPO_COMMS_CHUNK_SIZE
+#        define SIPO_COMMS_CHUNK_SIZE 1024
+#    endif
+
+// double buffer: one of them is (potentially) being sent by DMA while the other one gets filled
+static struct {
+    uint8_t buff[2][SIPO_COMMS_CHUNK_SIZE];
+    uint8_t index;
+} chunks = {0};
+
+// device whose CS is held low (along with the state of its DC line), it is only
+// released when comms are stopped or another device is used
+static struct {
+    painter_device_t device;
+    bool             dc;
+} selected = {0};
+
+static void release_cs(void) {
+    if (selected.device == NULL) {
+        return;
+    }
+
+    painter_driver_t      *driver       = (painter_driver_t *)selected.device;
+    qp_comms_spi_config_t *comms_config = (qp_comms_spi_config_t *)driver->comms_config;
+
+    // control lines must not change while data is still on the wire
+    spi_custom_wait(SCREENS_SPI_DRIVER_ID);
+
+    set_sipo_pin(comms_config->chip_select_pin, true);
+    send_sipo_state();
+
+    selected.device = NULL;
+}
+
 bool comms_sipo_init(painter_device_t device) {
     painter_driver_t      *driver       = (painter_driver_t *)device;
     qp_comms_spi_config_t *comms_config = (qp_comms_spi_config_t *)driver->comms_config;
@@ -38,11 +78,19 @@ bool comms_sipo_start(painter_device_t device) {
 uint32_t comms_sipo_send_data(__unused painter_device_t device, const void *data, uint32_t byte_count) {
     uint32_t       bytes_remaining = byte_count;
     const uint8_t *p               = (const uint8_t *)data;
-    uint32_t       max_msg_length  = 1024;
 
     while (bytes_remaining > 0) {
-        uint32_t bytes_this_loop = MIN(bytes_remaining, max_msg_length);
-        spi_custom_transmit(p, bytes_this_loop, SCREENS_SPI_DRIVER_ID);
+        uint32_t bytes_this_loop = MIN(bytes_remaining, SIPO_COMMS_CHUNK_SIZE);
+
+        // QP re-uses its buffer as soon as we return, copy the last chunk so that
+        // it is sent while QP prepares the next one. Others are sent straight away
+        const uint8_t *chunk = p;
+        if (bytes_this_loop == bytes_remaining) {
+            chunk = memcpy(chunks.buff[chunks.index], p, bytes_this_loop);
+            chunks.index ^= 1;
+        }
+
+        spi_custom_transmit_async(chunk, bytes_this_loop, SCREENS_SPI_DRIVER_ID);
         p += bytes_this_loop;
         bytes_remaining -= bytes_this_loop;
     }
@@ -54,6 +102,7 @@ bool comms_sipo_stop(painter_device_t device) {
     painter_driver_t      *driver       = (painter_driver_t *)device;
     qp_comms_spi_config_t *comms_config = (qp_comms_spi_config_t *)driver->comms_config;
 
+    release_cs();
     spi_custom_stop(SCREENS_SPI_DRIVER_ID);
 
     set_sipo_pin(comms_config->chip_select_pin, true);
@@ -95,38 +144,65 @@ bool comms_sipo_dc_reset_init(painter_device_t device) {
     return true;
 }
 
-uint32_t comms_sipo_dc_reset_send_data(painter_device_t device, const void *data, uint32_t byte_count) {
+// select device (if needed) and set DC, all changes are committed to the SIPO with a single write
+static void assert_cs(painter_device_t device, bool dc) {
+    if (selected.device == device && selected.dc == dc) {
+        return;
+    }
+
     painter_driver_t               *driver       = (painter_driver_t *)device;
     qp_comms_spi_dc_reset_config_t *comms_config = (qp_comms_spi_dc_reset_config_t *)driver->comms_config;
 
-    set_sipo_pin(comms_config->dc_pin, true);
-    set_sipo_pin(comms_config->spi_config.chip_select_pin, false);
-    send_sipo_state();
+    if (selected.device != device) {
+        release_cs();
 
-    uint32_t ret = comms_sipo_send_data(device, data, byte_count);
+#        if IS_ENABLED(QP_PROFILER)
+        qp_profiler_on_cs_toggle(device);
+#        endif
+    }
 
-    set_sipo_pin(comms_config->spi_config.chip_select_pin, true);
+    // control lines must not change while data is still on the wire
+    spi_custom_wait(SCREENS_SPI_DRIVER_ID);
+
+    set_sipo_pin(comms_config->dc_pin, dc);
+    set_sipo_pin(comms_config->spi_config.chip_select_pin, false);
     send_sipo_state();
 
-    return ret;
+    selected.device = device;
+    selected.dc     = dc;
 }
 
-bool comms_sipo_dc_reset_send_command(painter_device_t device, uint8_t cmd) {
-    painter_driver_t               *driver       = (painter_driver_t *)device;
-    qp_comms_spi_dc_reset_config_t *comms_config = (qp_comms_spi_dc_reset_config_t *)driver->comms_config;
+uint32_t comms_sipo_dc_reset_send_data(painter_device_t device, const void *data, uint32_t byte_count) {
+    // CS is kept low in between calls, consecutive chunks of data do not need
+    // to wait for the previous one to be sent
+    assert_cs(device, true);
+
+#        if IS_ENABLED(QP_PROFILER)
+    // time until data is actually on the wire, not just queued for DMA
+    // this gives up overlapping transfers with QP's work while profiling
+    const uint32_t start = qp_profiler_now();
+    const uint32_t sent  = comms_sipo_send_data(device, data, byte_count);
+    spi_custom_wait(SCREENS_SPI_DRIVER_ID);
+    qp_profiler_on_send(device, sent, qp_profiler_now() - start);
+    return sent;
+#        else
+    return comms_sipo_send_data(device, data, byte_count);
+#        endif
+}
 
-    set_sipo_pin(comms_config->dc_pin, false);
-    set_sipo_pin(comms_config->spi_config.chip_select_pin, false);
-    send_sipo_state();
+bool comms_sipo_dc_reset_send_command(painter_device_t device, uint8_t cmd) {
+    assert_cs(device, false);
 
     spi_custom_write(cmd, SCREENS_SPI_DRIVER_ID);
 
-    set_sipo_pin(comms_config->spi_config.chip_select_pin, true);
-    send_sipo_state();
+#        if IS_ENABLED(QP_PROFILER)
+    qp_profiler_on_command(device);
+#        endif
 
     return true;
 }
 
+// CS is held low for the whole sequence, only DC changes between command and parameters
 bool comms_sipo_dc_reset_bulk_command_sequence(painter_device_t device, const uint8_t *sequence, size_t sequence_len) {
     painter_driver_t               *driver       = (painter_driver_t *)device;
     qp_comms_spi_dc_reset_config_t *comms_config = (qp_comms_spi_dc_reset_config_t *)driver->comms_config;
@@ -137,11 +213,13 @@ bool comms_sipo_dc_reset_bulk_command_sequence(painter_device_t device, const ui
         comms_sipo_dc_reset_send_command(device, command);
         if (num_bytes > 0) {
             if (comms_config->command_params_uses_command_pin) {
+                // some panels latch every parameter as a command byte, keep sending them one by one
                 for (uint8_t j = 0; j < num_bytes; j++) {
                     comms_sipo_dc_reset_send_command(device, sequence[i + 3 + j]);
                 }
             } else {
-                comms_sipo_dc_reset_send_data(device, &sequence[i + 3], num_bytes);
+                assert_cs(device, true);
+                spi_custom_transmit(&sequence[i + 3], num_bytes, SCREENS_SPI_DRIVER_ID);
             }
         }
         if (delay > 0) {
@@ -181,6 +259,11 @@ bool comms_sipo_dc_reset_single_byte_send_command(painter_device_t device, uint8
     set_sipo_pin(comms_config->spi_config.chip_select_pin, true);
     send_sipo_state();
 
+#        if IS_ENABLED(QP_PROFILER)
+    qp_profiler_on_cs_toggle(device);
+    qp_profiler_on_command(device);
+#        endif
+
     return true;
 }
 
@@ -188,10 +271,20 @@ uint32_t comms_sipo_dc_reset_single_byte_send_data(painter_device_t device, cons
     painter_driver_t               *driver       = (painter_driver_t *)device;
     qp_comms_spi_dc_reset_config_t *comms_config = (qp_comms_spi_dc_reset_config_t *)driver->comms_config;
 
+#        if IS_ENABLED(QP_PROFILER)
+    const uint32_t start = qp_profiler_now();
+#        endif
+
     uint32_t       bytes_remaining = byte_count;
     const uint8_t *p               = (const uint8_t *)data;
     uint32_t       max_msg_length  = 1;
 
+    // device needs CS framing around every byte, but the shift registers' bus is kept running for the whole
+    // buffer, so that each toggle is just a latch instead of setting up (and tearing down) the driver
+    if (!sipo_burst_start()) {
+        return 0;
+    }
+
     set_sipo_pin(comms_config->dc_pin, true);
     while (bytes_remaining > 0) {
         uint32_t bytes_this_loop = MIN(bytes_remaining, max_msg_length);
@@ -204,14 +297,29 @@ uint32_t comms_sipo_dc_reset_single_byte_send_data(painter_device_t device, cons
         set_sipo_pin(comms_config->spi_config.chip_select_pin, true);
         send_sipo_state();
 
+#        if IS_ENABLED(QP_PROFILER)
+        qp_profiler_on_cs_toggle(device);
+#        endif
+
         p += bytes_this_loop;
         bytes_remaining -= bytes_this_loop;
     }
 
+    sipo_burst_end();
+
+#        if IS_ENABLED(QP_PROFILER)
+    // transfers above are blocking, data is already on the wire
+    qp_profiler_on_send(device, byte_count - bytes_remaining, qp_profiler_now() - start);
+#        endif
+
     return byte_count - bytes_remaining;
 }
 
 bool comms_sipo_dc_reset_single_byte_bulk_command_sequence(painter_device_t device, const uint8_t *sequence, size_t sequence_len) {
+    if (!sipo_burst_start()) {
+        return false;
+    }
+
     for (size_t i = 0; i < sequence_len;) {
         uint8_t command   = sequence[i];
         uint8_t delay     = sequence[i + 1];
@@ -226,6 +334,8 @@ bool comms_sipo_dc_reset_single_byte_bulk_command_sequence(painter_device_t devi
         i += (3 + num_bytes);
     }
 
+    sipo_burst_end();
+
     return true;
 }
 
@@ -0,0 +1,249 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/qp/stream.h"
+
+#include <quantum/compiler_support.h>
+#include <quantum/quantum.h>
+#include <string.h>
+
+STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
+#include "elpekenin/logging.h"
+
+// pixels decoded before being sent to the display
+#define BATCH_SIZE 32
+
+#define RUN_FLAG 0x80
+#define COUNT_MASK 0x7F
+
+static struct {
+    painter_device_t     device;
+    qp_stream_encoding_t encoding;
+    uint16_t             expected;
+    uint16_t             left;
+    uint16_t             top;
+    uint16_t             right;
+    uint16_t             bottom;
+    uint16_t             x; // where next pixel goes
+    uint16_t             y;
+    uint8_t              palette[QP_STREAM_PALETTE_SIZE][2];
+} stream = {0};
+
+static struct {
+    uint8_t pixels[BATCH_SIZE][2];
+    size_t  count;
+} batch = {0};
+
+bool qp_stream_begin(painter_device_t device, uint16_t left, uint16_t top, uint16_t right, uint16_t bottom, qp_stream_encoding_t encoding) {
+    stream.device = NULL;
+
+    if (encoding > QP_STREAM_PALETTE_RLE) {
+        logging(LOG_ERROR, "%s: unknown encoding %d", __func__, encoding);
+        return false;
+    }
+
+    if (!qp_viewport(device, left, top, right, bottom)) {
+        logging(LOG_ERROR, "%s: could not set viewport", __func__);
+        return false;
+    }
+
+    stream.device   = device;
+    stream.encoding = encoding;
+    stream.expected = 0;
+    stream.left     = left;
+    stream.top      = top;
+    stream.right    = right;
+    stream.bottom   = bottom;
+    stream.x        = left;
+    stream.y        = top;
+    batch.count     = 0;
+
+    return true;
+}
+
+bool qp_stream_set_palette(uint16_t start, const uint8_t *colors, uint16_t count) {
+    if (start + count > QP_STREAM_PALETTE_SIZE) {
+        logging(LOG_ERROR, "%s: palette too small", __func__);
+        return false;
+    }
+
+    memcpy(stream.palette[start], colors, count * sizeof(stream.palette[0]));
+    return true;
+}
+
+//
+// decoding
+//
+
+static inline size_t pixel_size(void) {
+    return stream.encoding == QP_STREAM_RLE ? 2 : 1;
+}
+
+// check that data is made of complete tokens, before drawing any of it
+static bool validate(const uint8_t *data, size_t length) {
+    size_t i = 0;
+
+    while (i < length) {
+        const uint8_t header = data[i++];
+        const size_t  count  = (header & COUNT_MASK) + 1;
+        const size_t  values = (header & RUN_FLAG) ? 1 : count;
+
+        if (i + values * pixel_size() > length) {
+            return false;
+        }
+
+        // indices must be within the palette
+        if (stream.encoding == QP_STREAM_PALETTE_RLE) {
+            for (size_t j = 0; j < values; ++j) {
+                if (data[i + j] >= QP_STREAM_PALETTE_SIZE) {
+                    return false;
+                }
+            }
+        }
+
+        i += values * pixel_size();
+    }
+
+    return i == length;
+}
+
+static void advance(size_t n_pixels) {
+    const size_t width  = stream.right - stream.left + 1;
+    const size_t offset = stream.x - stream.left + n_pixels;
+
+    stream.x = stream.left + offset % width;
+    stream.y += offset / width;
+}
+
+// something else may have drawn on the display between chunks, so the viewport is set again before each write
+// it covers the area left to be drawn, a partial row needs its own viewport for pixels not to wrap onto column `left`
+static bool flush_batch(void) {
+    size_t sent = 0;
+    bool   ok   = true;
+
+    while (sent < batch.count) {
+        if (stream.y > stream.bottom) {
+            logging(LOG_WARN, "%s: data past the end of the region", __func__);
+            break;
+        }
+
+        const size_t width = stream.right - stream.left + 1;
+
+        size_t n_pixels;
+        if (stream.x == stream.left) {
+            n_pixels = MIN(batch.count - sent, (stream.bottom - stream.y + 1) * width);
+            ok       = qp_viewport(stream.device, stream.left, stream.y, stream.right, stream.bottom);
+        } else {
+            n_pixels = MIN(batch.count - sent, stream.right - stream.x + 1);
+            ok       = qp_viewport(stream.device, stream.x, stream.y, stream.right, stream.y);
+        }
+
+        if (!ok) {
+            logging(LOG_ERROR, "%s: could not set viewport", __func__);
+            break;
+        }
+
+        ok = qp_pixdata(stream.device, batch.pixels[sent], n_pixels);
+        if (!ok) {
+            logging(LOG_ERROR, "%s: could not send pixels", __func__);
+            break;
+        }
+
+        advance(n_pixels);
+
+        sent += n_pixels;
+    }
+
+    batch.count = 0;
+    return ok;
+}
+
+static bool push_pixel(const uint8_t *value) {
+    const uint8_t *pixel = stream.encoding == QP_STREAM_RLE ? value : stream.palette[*value];
+
+    memcpy(batch.pixels[batch.count], pixel, sizeof(batch.pixels[0]));
+    batch.count += 1;
+
+    if (batch.count == BATCH_SIZE) {
+        return flush_batch();
+    }
+
+    return true;
+}
+
+static bool decode(const uint8_t *data, size_t length) {
+    size_t i = 0;
+
+    while (i < length) {
+        const uint8_t header = data[i++];
+        const size_t  count  = (header & COUNT_MASK) + 1;
+
+        if (header & RUN_FLAG) {
+            for (size_t j = 0; j < count; ++j) {
+                if (!push_pixel(&data[i])) {
+                    return false;
+                }
+            }
+
+            i += pixel_size();
+        } else {
+            for (size_t j = 0; j < count; ++j) {
+                if (!push_pixel(&data[i])) {
+                    return false;
+                }
+
+                i += pixel_size();
+            }
+        }
+    }
+
+    return flush_batch();
+}
+
+bool qp_stream_data(uint16_t seq, const uint8_t *data, size_t length, uint16_t *expected) {
+    if (stream.device == NULL) {
+        logging(LOG_ERROR, "%s: no stream", __func__);
+        goto err;
+    }
+
+    // already drawn, sender did not get our answer
+    if ((int16_t)(seq - stream.expected) < 0) {
+        *expected = stream.expected;
+        return true;
+    }
+
+    if (seq != stream.expected) {
+        logging(LOG_WARN, "%s: got chunk %d, expected %d", __func__, seq, stream.expected);
+        goto err;
+    }
+
+    if (!validate(data, length)) {
+        logging(LOG_ERROR, "%s: chunk %d is malformed", __func__, seq);
+        goto err;
+    }
+
+    // rejected chunk will be sent again, draw it from the same position
+    const uint16_t x = stream.x;
+    const uint16_t y = stream.y;
+
+    if (!decode(data, length)) {
+        logging(LOG_ERROR, "%s: could not draw chunk %d", __func__, seq);
+        stream.x    = x;
+        stream.y    = y;
+        batch.count = 0;
+        goto err;
+    }
+
+    stream.expected += 1;
+
+    *expected = stream.expected;
+    return true;
+
+err:
+    *expected = stream.expected;
+    return false;
+}
+
+uint16_t qp_stream_expected(void) {
+    return stream.expected;
+}
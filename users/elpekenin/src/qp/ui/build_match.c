@@ -3,6 +3,7 @@
 
 #include "elpekenin/qp/ui/build_match.h"
 
+#include "elpekenin/qp/assets.h"
 #include "elpekenin/split/transactions.h"
 #include "elpekenin/ui/utils.h"
 
@@ -18,7 +19,7 @@ ui_time_t build_match_render(const ui_node_t *self, painter_device_t display) {
         return (ui_time_t)UI_STOP;
     }
 
-    const painter_font_handle_t font = qp_load_font_mem(args->font);
+    const painter_font_handle_t font = acquire_font(args->font);
     if (font == NULL) {
         goto exit;
     }
@@ -54,7 +55,7 @@ ui_time_t build_match_render(const ui_node_t *self, painter_device_t display) {
     }
 
 err:
-    qp_close_font(font);
+    release_font(font);
 
 exit:
     return (ui_time_t)UI_MILLISECONDS(BUILD_MATCH_UI_REDRAW_INTERVAL);
@@ -3,25 +3,40 @@
 
 #include "elpekenin/qp/ui/computer.h"
 
-#include <quantum/compiler_support.h>
-
+#include "elpekenin/qp/graph.h"
 #include "elpekenin/xap.h"
 
-STATIC_ASSERT(CM_ENABLED(QP_HELPERS), "Must enable 'drashna/qp_helpers'");
-#include "qp_helpers.h"
-
-typedef struct {
-    size_t    points;
-    ui_time_t last_update;
-    uint8_t   cpu[COMPUTER_STATS_SIZE];
-    uint8_t   ram[COMPUTER_STATS_SIZE];
-} inner_state_t;
+#define CPU 0
+#define RAM 1
 
-static inner_state_t state = {0};
+// ring buffers, managed by the graph. pushing a sample is O(1), no shifting around
+static graph_column_t cpu_history[COMPUTER_STATS_SIZE] = {0};
+static graph_column_t ram_history[COMPUTER_STATS_SIZE] = {0};
 
-// if types are ever changed, memmove needs update
-STATIC_ASSERT(member_size(inner_state_t, cpu) == COMPUTER_STATS_SIZE, "memmove will use wrong size");
-STATIC_ASSERT(member_size(inner_state_t, ram) == COMPUTER_STATS_SIZE, "memmove will use wrong size");
+static graph_series_t series[] = {
+    [CPU] =
+        {
+            .color     = {HSV_BLUE},
+            .max_value = 100,
+            .history   = cpu_history,
+        },
+    [RAM] =
+        {
+            .color     = {HSV_YELLOW},
+            .max_value = 100,
+            .history   = ram_history,
+        },
+};
+
+static graph_t graph = {
+    .columns            = COMPUTER_STATS_SIZE,
+    .samples_per_column = COMPUTER_STATS_DECIMATION,
+    .axis               = {HSV_WHITE},
+    .background         = {HSV_BLACK},
+    .n_series           = ARRAY_SIZE(series),
+    .series             = series,
+    .dirty              = true,
+};
 
 bool computer_init(ui_node_t *self) {
     return true;
@@ -35,66 +50,36 @@ ui_time_t computer_render(const ui_node_t *self, painter_device_t display) {
         if (args->clear) {
             args->clear = false;
             qp_rect(display, self->start.x, self->start.y, self->start.x + self->size.x, self->start.y + self->size.y, HSV_BLACK, true);
+            graph_invalidate(&graph);
         }
 
         goto exit;
     }
 
-    if (ui_time_lte(state.last_update, args->last_draw)) {
-        goto exit;
+    // -1 just in case
+    if (graph_render(&graph, display, self->start.x, self->start.y, self->size.x - 1, self->size.y - 1)) {
+        args->clear = true;
     }
 
-    const graph_line_t lines[] = {
-        {
-            .data      = state.cpu,
-            .color     = {HSV_BLUE},
-            .mode      = LINE,
-            .max_value = 100,
-        },
-        {
-            .data      = state.ram,
-            .color     = {HSV_YELLOW},
-            .mode      = LINE,
-            .max_value = 100,
-        },
-        GRAPHS_END,
-    };
-
-    const graph_config_t config = {
-        .device = display,
-        .start =
-            {
-                .x = self->start.x,
-                .y = self->start.y,
-            },
-        .size =
-            {
-                // -1 just in case
-                .x = self->size.x - 1,
-                .y = self->size.y - 1,
-            },
-        .axis        = {HSV_WHITE},
-        .background  = {HSV_BLACK},
-        .data_points = state.points,
-    };
-
-    qp_draw_graph(&config, lines);
-
-    args->last_draw = ui_time_now();
-    args->clear     = true;
-
 exit:
     return (ui_time_t)UI_MILLISECONDS(COMPUTER_STATS_UI_REDRAW_INTERVAL);
 }
 
 void push_computer(uint8_t cpu, uint8_t ram) {
-    memmove(state.cpu + 1, state.cpu, COMPUTER_STATS_SIZE - 1);
-    memmove(state.ram + 1, state.ram, COMPUTER_STATS_SIZE - 1);
+    const uint8_t values[] = {
+        [CPU] = cpu,
+        [RAM] = ram,
+    };
 
-    state.cpu[0] = cpu;
-    state.ram[0] = ram;
+    graph_push(&graph, values);
+}
 
-    state.points = MIN(COMPUTER_STATS_SIZE, state.points + 1);
+void push_computer_batch(const uint8_t *cpu, const uint8_t *ram, size_t count) {
+    // older samples would be overwritten right away
+    const size_t history = COMPUTER_STATS_SIZE * MAX(COMPUTER_STATS_DECIMATION, 1);
+    const size_t skip    = count > history ? count - history : 0;
 
-    state.last_update = ui_time_now();
+    for (size_t i = skip; i < count; ++i) {
+        push_computer(cpu[i], ram[i]);
+    }
 }
@@ -3,6 +3,7 @@
 
 #include "elpekenin/qp/ui/github.h"
 
+#include "elpekenin/qp/assets.h"
 #include "elpekenin/ui/utils.h"
 #include "elpekenin/xap.h"
 
@@ -18,7 +19,7 @@ bool github_init(ui_node_t *self) {
 ui_time_t github_render(const ui_node_t *self, painter_device_t display) {
     github_args_t *const args = self->args;
 
-    const painter_image_handle_t image = qp_load_image_mem(args->logo);
+    const painter_image_handle_t image = acquire_image(args->logo);
     if (image == NULL) {
         goto exit;
     }
@@ -62,7 +63,7 @@ ui_time_t github_render(const ui_node_t *self, painter_device_t display) {
     args->clear     = true;
 
 err:
-    qp_close_image(image);
+    release_image(image);
 
 exit:
     return (ui_time_t)UI_MILLISECONDS(GITHUB_NOTIFICATIONS_UI_REDRAW_INTERVAL);
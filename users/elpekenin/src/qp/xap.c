@@ -1,9 +1,6 @@
 // Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
-// TODO
-// - Maybe the XAP answer should be success/failure based on the output from QP functions, returning success for now as in "your request has been handled"
-
 #include "elpekenin/xap.h"
 
 #include <quantum/quantum.h>
@@ -18,6 +15,26 @@
 #    include "elpekenin/scrolling_text.h"
 #endif
 
+#if IS_ENABLED(QP_DISPLAY_LIST)
+#    include "elpekenin/qp/display_list.h"
+#endif
+
+#if IS_ENABLED(QP_PROFILER)
+#    include "elpekenin/qp/profiler.h"
+#endif
+
+#if IS_ENABLED(QP_STREAM)
+#    include "elpekenin/qp/stream.h"
+#endif
+
+#if IS_ENABLED(QP_FRAMEBUFFER)
+#    include "elpekenin/qp/framebuffer.h"
+#endif
+
+#ifndef XAP_DEFERRED_FLUSHES
+#    define XAP_DEFERRED_FLUSHES 2
+#endif
+
 static inline uint8_t lsb(uint16_t val) {
     return val & 0xFF;
 }
@@ -26,16 +43,114 @@ static inline uint8_t msb(uint16_t val) {
     return (val >> 8) & 0xFF;
 }
 
-static inline void xap_slave(const void *data) {
+// answer with the outcome of a request, on slave it gets reported back to master instead
+static void xap_result(xap_token_t token, bool ok) {
+    if (!is_keyboard_master()) {
+        xap_slave_result(ok);
+        return;
+    }
+
+    if (ok) {
+        xap_respond_success(token);
+    } else {
+        xap_respond_failure(token, 0);
+    }
+}
+
+// answer with the id to query the result later
+static void xap_deferred(xap_token_t token, uint16_t id) {
+    const uint8_t ret[3] = {XAP_DEFERRED_MARKER, lsb(id), msb(id)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+}
+
+// hand the request over to slave, answer with the id to query its result
+static bool xap_forward(xap_token_t token, const void *data) {
     // offset backwards into start of the XAP message
     // { user, qp, operation } = 3 bytes to offset
     const void *start = data - sizeof(xap_request_header_t) - 3;
-    xap_execute_slave(start);
+
+    uint16_t id;
+    if (!xap_execute_slave(start, &id)) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_deferred(token, id);
+    return true;
 }
 
-static inline void xap_preprocess(xap_token_t token) {
-    xap_respond_success(token);
+// devices on the registry may be a framebuffer's surface, panel-level operations go to the display behind it
+static inline painter_device_t panel(painter_device_t device) {
+#if IS_ENABLED(QP_FRAMEBUFFER)
+    return qp_framebuffer_target(device);
+#else
+    return device;
+#endif
+}
+
+// qp_drawtext returns the width drawn, not a status
+static inline bool drawtext_ok(int16_t width, const uint8_t *text) {
+    return width > 0 || text[0] == '\0';
+}
+
+//
+// deferred results
+//
+
+// flushing can take a while (eg: e-ink), it runs after answering
+typedef struct {
+    painter_device_t device;
+    uint16_t         id;
+} deferred_flush_t;
+
+static deferred_flush_t flushes[XAP_DEFERRED_FLUSHES] = {0};
+
+static uint32_t flush_cb(__unused uint32_t trigger_time, void *cb_arg) {
+    deferred_flush_t *flush = cb_arg;
+
+    xap_completion_done(flush->id, qp_flush(flush->device));
+    flush->device = NULL;
+
+    return 0;
+}
+
+static bool xap_flush(xap_token_t token, painter_device_t device) {
+    // on slave, result has to be known before the handler returns
+    if (!is_keyboard_master()) {
+        xap_result(token, qp_flush(device));
+        return true;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(flushes); ++i) {
+        if (flushes[i].device != NULL) {
+            continue;
+        }
+
+        flushes[i].device = device;
+        flushes[i].id     = xap_completion_new();
+
+        if (defer_exec(1, flush_cb, &flushes[i]) == INVALID_DEFERRED_TOKEN) {
+            flushes[i].device = NULL;
+            xap_completion_done(flushes[i].id, false);
+            break;
+        }
+
+        xap_deferred(token, flushes[i].id);
+        return true;
+    }
+
+    // no room to defer it, run right away
+    xap_result(token, qp_flush(device));
+    return true;
+}
+
+bool xap_execute_completion(xap_token_t token, xap_route_user_quantum_painter_completion_arg_t *arg) {
     xap_last_activity_update();
+
+    const uint8_t ret = xap_completion_get(arg->id);
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &ret, sizeof(ret));
+
+    return true;
 }
 
 //
@@ -43,199 +158,221 @@ static inline void xap_preprocess(xap_token_t token) {
 //
 
 bool xap_execute_qp_clear(xap_token_t token, xap_route_user_quantum_painter_clear_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_clear(device);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_clear(device));
     return true;
 }
 
 bool xap_execute_qp_setpixel(xap_token_t token, xap_route_user_quantum_painter_setpixel_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_setpixel(device, arg->x, arg->y, arg->hue, arg->sat, arg->val);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_setpixel(device, arg->x, arg->y, arg->hue, arg->sat, arg->val));
     return true;
 }
 
 bool xap_execute_qp_line(xap_token_t token, xap_route_user_quantum_painter_draw_line_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_line(device, arg->x0, arg->y0, arg->x1, arg->y1, arg->hue, arg->sat, arg->val);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_line(device, arg->x0, arg->y0, arg->x1, arg->y1, arg->hue, arg->sat, arg->val));
     return true;
 }
 
 bool xap_execute_qp_rect(xap_token_t token, xap_route_user_quantum_painter_draw_rect_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_rect(device, arg->left, arg->top, arg->right, arg->bottom, arg->hue, arg->sat, arg->val, arg->filled);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_rect(device, arg->left, arg->top, arg->right, arg->bottom, arg->hue, arg->sat, arg->val, arg->filled));
     return true;
 }
 
 bool xap_execute_qp_circle(xap_token_t token, xap_route_user_quantum_painter_draw_circle_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_circle(device, arg->x, arg->y, arg->radius, arg->hue, arg->sat, arg->val, arg->filled);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_circle(device, arg->x, arg->y, arg->radius, arg->hue, arg->sat, arg->val, arg->filled));
     return true;
 }
 
 bool xap_execute_qp_ellipse(xap_token_t token, xap_route_user_quantum_painter_draw_ellipse_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_ellipse(device, arg->x, arg->y, arg->sizex, arg->sizey, arg->hue, arg->sat, arg->val, arg->filled);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_ellipse(device, arg->x, arg->y, arg->sizex, arg->sizey, arg->hue, arg->sat, arg->val, arg->filled));
     return true;
 }
 
 bool xap_execute_qp_drawimage(xap_token_t token, xap_route_user_quantum_painter_drawimage_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_image_handle_t image = get_image_by_name((const char *)arg->image_name);
     if (image == NULL) {
         printf("Unknown image: %s\n", arg->image_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_drawimage(device, arg->x, arg->y, image);
+        release_image(image);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_drawimage(device, arg->x, arg->y, image));
+    release_image(image);
+
     return true;
 }
 
 bool xap_execute_qp_drawimage_recolor(xap_token_t token, xap_route_user_quantum_painter_drawimage_recolor_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_image_handle_t image = get_image_by_name((const char *)arg->image_name);
     if (image == NULL) {
         printf("Unknown image: %s\n", arg->image_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_drawimage_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg);
+        release_image(image);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_drawimage_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg));
+    release_image(image);
+
     return true;
 }
 
 bool xap_execute_qp_animate(xap_token_t token, xap_route_user_quantum_painter_animate_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_image_handle_t image = get_image_by_name((const char *)arg->image_name);
     if (image == NULL) {
         printf("Unknown image: %s\n", arg->image_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_animate(device, arg->x, arg->y, image);
+        release_image(image);
+        return xap_forward(token, arg);
     }
 
+    // animations run until stopped (which nothing does), image stays open for good
+    const deferred_token anim = qp_animate(device, arg->x, arg->y, image);
+    if (anim != INVALID_DEFERRED_TOKEN) {
+        pin_image(image);
+    }
+    release_image(image);
+
+    xap_result(token, anim != INVALID_DEFERRED_TOKEN);
     return true;
 }
 
 bool xap_execute_qp_animate_recolor(xap_token_t token, xap_route_user_quantum_painter_animate_recolor_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_image_handle_t image = get_image_by_name((const char *)arg->image_name);
     if (image == NULL) {
         printf("Unknown image: %s\n", arg->image_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_animate_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg);
+        release_image(image);
+        return xap_forward(token, arg);
     }
 
+    // animations run until stopped (which nothing does), image stays open for good
+    const deferred_token anim = qp_animate_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg);
+    if (anim != INVALID_DEFERRED_TOKEN) {
+        pin_image(image);
+    }
+    release_image(image);
+
+    xap_result(token, anim != INVALID_DEFERRED_TOKEN);
     return true;
 }
 
 bool xap_execute_qp_drawtext(xap_token_t token, xap_route_user_quantum_painter_drawtext_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_font_handle_t font = get_font_by_name((const char *)arg->font_name);
     if (font == NULL) {
         printf("Unknown font: %s\n", arg->font_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_drawtext(device, arg->x, arg->y, font, (const char *)arg->text);
+        release_font(font);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, drawtext_ok(qp_drawtext(device, arg->x, arg->y, font, (const char *)arg->text), arg->text));
+    release_font(font);
+
     return true;
 }
 
 bool xap_execute_qp_drawtext_recolor(xap_token_t token, xap_route_user_quantum_painter_drawtext_recolor_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_font_handle_t font = get_font_by_name((const char *)arg->font_name);
     if (font == NULL) {
         printf("Unknown font: %s\n", arg->font_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_drawtext_recolor(device, arg->x, arg->y, font, (const char *)arg->text, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg);
+        release_font(font);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, drawtext_ok(qp_drawtext_recolor(device, arg->x, arg->y, font, (const char *)arg->text, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg), arg->text));
+    release_font(font);
+
     return true;
 }
 
 bool xap_execute_qp_get_geometry(xap_token_t token, xap_route_user_quantum_painter_get_geometry_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     painter_rotation_t rotation;
     uint16_t           width;
@@ -245,45 +382,42 @@ bool xap_execute_qp_get_geometry(xap_token_t token, xap_route_user_quantum_paint
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_get_geometry(device, &width, &height, &rotation, &offset_x, &offset_y);
-
-        uint8_t ret[9] = {lsb(width), msb(width), lsb(height), msb(height), rotation, lsb(offset_x), msb(offset_x), lsb(offset_y), msb(offset_y)};
-        xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+        return xap_forward(token, arg);
     }
 
+    qp_get_geometry(panel(device), &width, &height, &rotation, &offset_x, &offset_y);
+
+    uint8_t ret[9] = {lsb(width), msb(width), lsb(height), msb(height), rotation, lsb(offset_x), msb(offset_x), lsb(offset_y), msb(offset_y)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+
     return true;
 }
 
 bool xap_execute_qp_flush(xap_token_t token, xap_route_user_quantum_painter_flush_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_flush(device);
+        return xap_forward(token, arg);
     }
 
-    return true;
+    return xap_flush(token, device);
 }
 
 bool xap_execute_qp_viewport(xap_token_t token, xap_route_user_quantum_painter_viewport_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_viewport(device, arg->left, arg->top, arg->right, arg->bottom);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_viewport(device, arg->left, arg->top, arg->right, arg->bottom));
     return true;
 }
 
 bool xap_respond_qp_pixdata(xap_token_t token, const uint8_t *data, size_t data_len) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const xap_route_user_quantum_painter_pixdata_arg_t *arg = (void *)data;
 
@@ -292,20 +426,20 @@ bool xap_respond_qp_pixdata(xap_token_t token, const uint8_t *data, size_t data_
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        qp_pixdata(device, (const void *)arg->pixels, n_pixels);
+        return xap_forward(token, arg);
     }
 
+    xap_result(token, qp_pixdata(device, (const void *)arg->pixels, n_pixels));
     return true;
 }
 
 bool xap_execute_qp_textwidth(xap_token_t token, xap_route_user_quantum_painter_textwidth_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_font_handle_t font = get_font_by_name((const char *)arg->font_name);
     if (font == NULL) {
         printf("Unknown font: %s\n", arg->font_name);
+        xap_result(token, false);
         return true;
     }
 
@@ -314,6 +448,8 @@ bool xap_execute_qp_textwidth(xap_token_t token, xap_route_user_quantum_painter_
     uint8_t ret[2] = {lsb(width), msb(width)};
     xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
 
+    release_font(font);
+
     return true;
 }
 
@@ -321,51 +457,754 @@ bool xap_execute_qp_textwidth(xap_token_t token, xap_route_user_quantum_painter_
 // scrolling text
 //
 #if CM_ENABLED(SCROLLING_TEXT)
+#    ifndef XAP_SCROLLING_TEXTS
+#        define XAP_SCROLLING_TEXTS 4
+#    endif
+
+// text keeps scrolling with its font, reference is held until it gets stopped
+typedef struct {
+    deferred_token        token;
+    painter_font_handle_t font;
+} scrolling_font_t;
+
+static scrolling_font_t scrolling_fonts[XAP_SCROLLING_TEXTS] = {0};
+
+static void scrolling_font_hold(deferred_token def_token, painter_font_handle_t font) {
+    for (size_t i = 0; i < ARRAY_SIZE(scrolling_fonts); ++i) {
+        if (scrolling_fonts[i].token == INVALID_DEFERRED_TOKEN) {
+            scrolling_fonts[i] = (scrolling_font_t){
+                .token = def_token,
+                .font  = font,
+            };
+            return;
+        }
+    }
+
+    // can't track when it stops, keep font open for good
+    pin_font(font);
+    release_font(font);
+}
+
+static void scrolling_font_release(deferred_token def_token) {
+    for (size_t i = 0; i < ARRAY_SIZE(scrolling_fonts); ++i) {
+        if (scrolling_fonts[i].token == def_token) {
+            release_font(scrolling_fonts[i].font);
+            scrolling_fonts[i] = (scrolling_font_t){0};
+            return;
+        }
+    }
+}
+
+// answer with the token to control the text
+static void scrolling_text_result(xap_token_t token, deferred_token def_token, painter_font_handle_t font) {
+    if (def_token == INVALID_DEFERRED_TOKEN) {
+        release_font(font);
+        xap_result(token, false);
+        return;
+    }
+
+    scrolling_font_hold(def_token, font);
+
+    if (!is_keyboard_master()) {
+        xap_slave_result(true);
+        return;
+    }
+
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &def_token, sizeof(deferred_token));
+}
+
 bool xap_execute_draw_scrolling_text(xap_token_t token, xap_route_user_quantum_painter_scrolling_text_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
 
     const painter_font_handle_t font = get_font_by_name((const char *)arg->font_name);
     if (font == NULL) {
         printf("Unknown font: %s\n", arg->font_name);
+        xap_result(token, false);
         return true;
     }
 
     const painter_device_t device = get_device_by_name((const char *)arg->device_name);
     if (device == NULL) {
-        xap_slave(arg);
-    } else {
-        const scrolling_text_config_t config = {
-            .device  = device,
-            .x       = arg->x,
-            .y       = arg->y,
-            .font    = font,
-            .n_chars = arg->n_chars,
-            .delay   = arg->delay,
-            .spaces  = 5,
-            .bg      = {HSV_BLACK},
-            .fg      = {HSV_WHITE},
+        release_font(font);
+        return xap_forward(token, arg);
+    }
+
+    const scrolling_text_config_t config = {
+        .device  = device,
+        .x       = arg->x,
+        .y       = arg->y,
+        .font    = font,
+        .n_chars = arg->n_chars,
+        .delay   = arg->delay,
+        .spaces  = 5,
+        .bg      = {HSV_BLACK},
+        .fg      = {HSV_WHITE},
 #    if SCROLLING_TEXT_USE_ALLOCATOR
-            .allocator = c_runtime_allocator,
+        .allocator = c_runtime_allocator,
 #    endif
-        };
+    };
 
-        const deferred_token def_token = scrolling_text_start(&config, (char *)arg->text);
-
-        xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &def_token, sizeof(deferred_token));
-    }
+    const deferred_token def_token = scrolling_text_start(&config, (char *)arg->text);
+    scrolling_text_result(token, def_token, font);
 
     return true;
 }
 
 bool xap_execute_stop_scrolling_text(xap_token_t token, xap_route_user_quantum_painter_stop_scrolling_text_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
     scrolling_text_stop(arg->token);
+    scrolling_font_release(arg->token);
+    xap_respond_success(token);
     return true;
 }
 
 bool xap_execute_extend_scrolling_text(xap_token_t token, xap_route_user_quantum_painter_extend_scrolling_text_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
     scrolling_text_extend(arg->token, (const char *)arg->text);
+    xap_respond_success(token);
+    return true;
+}
+#endif
+
+//
+// QP control, by id
+//
+
+#define RESOLVE_DEVICE 0
+#define RESOLVE_FONT 1
+#define RESOLVE_IMAGE 2
+
+// device ids with this bit set refer to the other half's displays, so that indexes on both sides don't clash
+// NOTE: fonts and images are the same on both halves (same firmware), their ids don't need it
+#define DEVICE_ID_OTHER_HALF (1 << 7)
+
+static inline bool device_is_remote(uint8_t device_id) {
+    return is_keyboard_master() && (device_id & DEVICE_ID_OTHER_HALF) != 0;
+}
+
+// on master, devices here have the bit clear. on slave, every request was forwarded, thus the bit is set
+static painter_device_t device_by_id(uint8_t device_id) {
+    const bool other_half = (device_id & DEVICE_ID_OTHER_HALF) != 0;
+    if (other_half == is_keyboard_master()) {
+        return NULL;
+    }
+
+    return get_device_by_index(device_id & ~DEVICE_ID_OTHER_HALF);
+}
+
+bool xap_execute_qp_resolve(xap_token_t token, xap_route_user_quantum_painter_id_resolve_arg_t *arg) {
+    xap_last_activity_update();
+
+    const char *name = (const char *)arg->name;
+
+    size_t  index = 0;
+    uint8_t flags = 0;
+    bool    found = false;
+    switch (arg->kind) {
+        case RESOLVE_DEVICE:
+            found = get_device_index(name, &index);
+            if (!found && IS_DEFINED(SPLIT_KEYBOARD)) {
+                found = get_slave_device_index(name, &index);
+                flags = DEVICE_ID_OTHER_HALF;
+            }
+
+            // the upper bit is taken
+            if (index >= DEVICE_ID_OTHER_HALF) {
+                found = false;
+            }
+            break;
+
+        case RESOLVE_FONT:
+            found = get_font_index(name, &index);
+            break;
+
+        case RESOLVE_IMAGE:
+            found = get_image_index(name, &index);
+            break;
+    }
+
+    if (!found || index > UINT8_MAX) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    const uint8_t ret = index | flags;
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &ret, sizeof(ret));
+
+    return true;
+}
+
+bool xap_execute_qp_clear_id(xap_token_t token, xap_route_user_quantum_painter_id_clear_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_clear(device));
+    return true;
+}
+
+bool xap_execute_qp_setpixel_id(xap_token_t token, xap_route_user_quantum_painter_id_setpixel_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_setpixel(device, arg->x, arg->y, arg->hue, arg->sat, arg->val));
+    return true;
+}
+
+bool xap_execute_qp_line_id(xap_token_t token, xap_route_user_quantum_painter_id_draw_line_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_line(device, arg->x0, arg->y0, arg->x1, arg->y1, arg->hue, arg->sat, arg->val));
+    return true;
+}
+
+bool xap_execute_qp_rect_id(xap_token_t token, xap_route_user_quantum_painter_id_draw_rect_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_rect(device, arg->left, arg->top, arg->right, arg->bottom, arg->hue, arg->sat, arg->val, arg->filled));
+    return true;
+}
+
+bool xap_execute_qp_circle_id(xap_token_t token, xap_route_user_quantum_painter_id_draw_circle_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_circle(device, arg->x, arg->y, arg->radius, arg->hue, arg->sat, arg->val, arg->filled));
+    return true;
+}
+
+bool xap_execute_qp_ellipse_id(xap_token_t token, xap_route_user_quantum_painter_id_draw_ellipse_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_ellipse(device, arg->x, arg->y, arg->sizex, arg->sizey, arg->hue, arg->sat, arg->val, arg->filled));
+    return true;
+}
+
+bool xap_execute_qp_drawimage_id(xap_token_t token, xap_route_user_quantum_painter_id_drawimage_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_image_handle_t image = get_image_by_index(arg->image_id);
+    if (image == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_drawimage(device, arg->x, arg->y, image));
+    release_image(image);
+
+    return true;
+}
+
+bool xap_execute_qp_drawimage_recolor_id(xap_token_t token, xap_route_user_quantum_painter_id_drawimage_recolor_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_image_handle_t image = get_image_by_index(arg->image_id);
+    if (image == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_drawimage_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg));
+    release_image(image);
+
+    return true;
+}
+
+bool xap_execute_qp_animate_id(xap_token_t token, xap_route_user_quantum_painter_id_animate_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_image_handle_t image = get_image_by_index(arg->image_id);
+    if (image == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    // animations run until stopped (which nothing does), image stays open for good
+    const deferred_token anim = qp_animate(device, arg->x, arg->y, image);
+    if (anim != INVALID_DEFERRED_TOKEN) {
+        pin_image(image);
+    }
+    release_image(image);
+
+    xap_result(token, anim != INVALID_DEFERRED_TOKEN);
+    return true;
+}
+
+bool xap_execute_qp_animate_recolor_id(xap_token_t token, xap_route_user_quantum_painter_id_animate_recolor_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_image_handle_t image = get_image_by_index(arg->image_id);
+    if (image == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    // animations run until stopped (which nothing does), image stays open for good
+    const deferred_token anim = qp_animate_recolor(device, arg->x, arg->y, image, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg);
+    if (anim != INVALID_DEFERRED_TOKEN) {
+        pin_image(image);
+    }
+    release_image(image);
+
+    xap_result(token, anim != INVALID_DEFERRED_TOKEN);
+    return true;
+}
+
+// NOTE: `text` is followed by `text_ext` and the terminator, use it as a single (longer) string
+bool xap_execute_qp_drawtext_id(xap_token_t token, xap_route_user_quantum_painter_id_drawtext_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_font_handle_t font = get_font_by_index(arg->font_id);
+    if (font == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, drawtext_ok(qp_drawtext(device, arg->x, arg->y, font, (const char *)arg->text), arg->text));
+    release_font(font);
+
+    return true;
+}
+
+bool xap_execute_qp_drawtext_recolor_id(xap_token_t token, xap_route_user_quantum_painter_id_drawtext_recolor_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_font_handle_t font = get_font_by_index(arg->font_id);
+    if (font == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, drawtext_ok(qp_drawtext_recolor(device, arg->x, arg->y, font, (const char *)arg->text, arg->hue_fg, arg->sat_fg, arg->val_fg, arg->hue_bg, arg->sat_bg, arg->val_bg), arg->text));
+    release_font(font);
+
+    return true;
+}
+
+bool xap_execute_qp_get_geometry_id(xap_token_t token, xap_route_user_quantum_painter_id_get_geometry_arg_t *arg) {
+    xap_last_activity_update();
+
+    painter_rotation_t rotation;
+    uint16_t           width;
+    uint16_t           height;
+    uint16_t           offset_x;
+    uint16_t           offset_y;
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    qp_get_geometry(panel(device), &width, &height, &rotation, &offset_x, &offset_y);
+
+    uint8_t ret[9] = {lsb(width), msb(width), lsb(height), msb(height), rotation, lsb(offset_x), msb(offset_x), lsb(offset_y), msb(offset_y)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+
+    return true;
+}
+
+bool xap_execute_qp_flush_id(xap_token_t token, xap_route_user_quantum_painter_id_flush_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    return xap_flush(token, device);
+}
+
+bool xap_execute_qp_viewport_id(xap_token_t token, xap_route_user_quantum_painter_id_viewport_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_viewport(device, arg->left, arg->top, arg->right, arg->bottom));
+    return true;
+}
+
+bool xap_respond_qp_pixdata_id(xap_token_t token, const uint8_t *data, size_t data_len) {
+    xap_last_activity_update();
+
+    const xap_route_user_quantum_painter_id_pixdata_arg_t *arg = (void *)data;
+
+    const uint8_t device_id_len = 1;
+
+    // at least one pixel, and no half ones
+    if (data_len < device_id_len + 2 || (data_len - device_id_len) % 2 != 0) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const uint8_t n_pixels = (data_len - device_id_len) / 2;
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    xap_result(token, qp_pixdata(device, (const void *)arg->pixels, n_pixels));
+    return true;
+}
+
+bool xap_execute_qp_textwidth_id(xap_token_t token, xap_route_user_quantum_painter_id_textwidth_arg_t *arg) {
+    xap_last_activity_update();
+
+    const painter_font_handle_t font = get_font_by_index(arg->font_id);
+    if (font == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    int16_t width = qp_textwidth(font, (const char *)arg->text);
+
+    uint8_t ret[2] = {lsb(width), msb(width)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+
+    release_font(font);
+
+    return true;
+}
+
+#if CM_ENABLED(SCROLLING_TEXT)
+bool xap_execute_draw_scrolling_text_id(xap_token_t token, xap_route_user_quantum_painter_id_scrolling_text_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (device_is_remote(arg->device_id)) {
+        return xap_forward(token, arg);
+    }
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const painter_font_handle_t font = get_font_by_index(arg->font_id);
+    if (font == NULL) {
+        xap_result(token, false);
+        return true;
+    }
+
+    const scrolling_text_config_t config = {
+        .device  = device,
+        .x       = arg->x,
+        .y       = arg->y,
+        .font    = font,
+        .n_chars = arg->n_chars,
+        .delay   = arg->delay,
+        .spaces  = 5,
+        .bg      = {HSV_BLACK},
+        .fg      = {HSV_WHITE},
+#    if SCROLLING_TEXT_USE_ALLOCATOR
+        .allocator = c_runtime_allocator,
+#    endif
+    };
+
+    const deferred_token def_token = scrolling_text_start(&config, (char *)arg->text);
+    scrolling_text_result(token, def_token, font);
+
+    return true;
+}
+#endif
+
+//
+// pixel streams
+//
+#if IS_ENABLED(QP_STREAM)
+// NOTE: streams are not forwarded to the other half
+bool xap_execute_qp_stream_begin(xap_token_t token, xap_route_user_quantum_painter_id_stream_begin_arg_t *arg) {
+    xap_last_activity_update();
+
+    const painter_device_t device = device_by_id(arg->device_id);
+    if (device == NULL || !qp_stream_begin(device, arg->left, arg->top, arg->right, arg->bottom, arg->encoding)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    xap_respond_success(token);
+    return true;
+}
+
+bool xap_execute_qp_stream_palette(xap_token_t token, xap_route_user_quantum_painter_id_stream_palette_arg_t *arg) {
+    xap_last_activity_update();
+
+    const size_t max_colors = (sizeof(arg->colors) + sizeof(arg->colors_ext)) / 2;
+    if (arg->count > max_colors || !qp_stream_set_palette(arg->start, arg->colors, arg->count)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    xap_respond_success(token);
+    return true;
+}
+
+// NOTE: always answers success, with the chunk's outcome on the payload, so that the sender knows where to resume
+bool xap_execute_qp_stream_data(xap_token_t token, xap_route_user_quantum_painter_id_stream_data_arg_t *arg) {
+    xap_last_activity_update();
+
+    uint16_t expected = qp_stream_expected();
+    bool     accepted = false;
+    if (arg->length <= sizeof(arg->data) + sizeof(arg->data_ext)) {
+        accepted = qp_stream_data(arg->seq, arg->data, arg->length, &expected);
+    }
+
+    uint8_t ret[3] = {accepted, lsb(expected), msb(expected)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+
+    return true;
+}
+#endif
+
+//
+// profiler
+//
+#if IS_ENABLED(QP_PROFILER)
+// NOTE: stats are not forwarded to the other half, only this side's displays are reported
+bool xap_execute_qp_profiler_device(xap_token_t token, xap_route_user_quantum_painter_profiler_device_arg_t *arg) {
+    xap_last_activity_update();
+
+    painter_device_t           device;
+    qp_profiler_device_stats_t stats;
+    if (!qp_profiler_get_device_stats(arg->index, &device, &stats)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    size_t index;
+    if (!qp_profiler_device_index(device, &index)) {
+        index = UINT8_MAX;
+    }
+
+    const struct PACKED {
+        uint8_t                    id;
+        qp_profiler_device_stats_t stats;
+    } ret = {
+        .id    = index,
+        .stats = stats,
+    };
+
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &ret, sizeof(ret));
+    return true;
+}
+
+#    if CM_ENABLED(UI)
+bool xap_execute_qp_profiler_node(xap_token_t token, xap_route_user_quantum_painter_profiler_node_arg_t *arg) {
+    xap_last_activity_update();
+
+    const ui_node_t         *node;
+    qp_profiler_node_stats_t stats;
+    if (!qp_profiler_get_node_stats(arg->index, &node, &stats)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    const struct PACKED {
+        uint16_t                 x;
+        uint16_t                 y;
+        uint16_t                 width;
+        uint16_t                 height;
+        qp_profiler_node_stats_t stats;
+    } ret = {
+        .x      = node->start.x,
+        .y      = node->start.y,
+        .width  = node->size.x,
+        .height = node->size.y,
+        .stats  = stats,
+    };
+
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, &ret, sizeof(ret));
+    return true;
+}
+#    else
+bool xap_execute_qp_profiler_node(xap_token_t token, __unused xap_route_user_quantum_painter_profiler_node_arg_t *arg) {
+    xap_last_activity_update();
+    xap_respond_failure(token, 0);
+    return true;
+}
+#    endif
+
+bool xap_execute_qp_profiler_reset(xap_token_t token) {
+    xap_last_activity_update();
+    qp_profiler_reset();
+    xap_respond_success(token);
+    return true;
+}
+#endif
+
+//
+// display list
+//
+#if IS_ENABLED(QP_DISPLAY_LIST)
+#    define DISPLAY_LIST_FIRST 0x01
+#    define DISPLAY_LIST_LAST 0x02
+#    define DISPLAY_LIST_FLUSH 0x04
+
+bool xap_execute_qp_display_list(xap_token_t token, xap_route_user_quantum_painter_display_list_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (arg->flags & DISPLAY_LIST_FIRST) {
+        qp_display_list_reset();
+    }
+
+    if (arg->length > sizeof(arg->data) || !qp_display_list_append(arg->data, arg->length)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    if (!(arg->flags & DISPLAY_LIST_LAST)) {
+        xap_respond_success(token);
+        return true;
+    }
+
+    uint16_t executed;
+    if (!qp_display_list_execute(arg->flags & DISPLAY_LIST_FLUSH, &executed)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    uint8_t ret[2] = {lsb(executed), msb(executed)};
+    xap_send(token, XAP_RESPONSE_FLAG_SUCCESS, (const void *)ret, sizeof(ret));
+
     return true;
 }
 #endif
@@ -375,13 +1214,28 @@ bool xap_execute_extend_scrolling_text(xap_token_t token, xap_route_user_quantum
 //
 
 bool xap_execute_push_computer(xap_token_t token, xap_route_user_tasks_push_computer_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
     push_computer(arg->cpu, arg->ram);
+    xap_respond_success(token);
+    return true;
+}
+
+bool xap_execute_push_computer_batch(xap_token_t token, xap_route_user_tasks_push_computer_batch_arg_t *arg) {
+    xap_last_activity_update();
+
+    if (arg->count > sizeof(arg->cpu)) {
+        xap_respond_failure(token, 0);
+        return true;
+    }
+
+    push_computer_batch(arg->cpu, arg->ram, arg->count);
+    xap_respond_success(token);
     return true;
 }
 
 bool xap_execute_set_github_count(xap_token_t token, xap_route_user_tasks_set_github_count_arg_t *arg) {
-    xap_preprocess(token);
+    xap_last_activity_update();
     set_github_count(arg->count);
+    xap_respond_success(token);
     return true;
 }
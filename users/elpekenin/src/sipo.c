@@ -20,6 +20,7 @@ STATIC_ASSERT(N_SIPO_PINS <= UINT8_MAX, "too many pins defined");
 
 static uint8_t sipo_pin_state[SIPO_BYTES] = {0};
 static bool    sipo_state_changed         = true;
+static uint8_t sipo_burst_depth           = 0;
 
 static void print_sipo_status(void) {
     sipo_dprintf("MCU | ");
@@ -60,6 +61,25 @@ void set_sipo_pin(uint8_t pin, bool state) {
     }
 }
 
+static bool sipo_spi_start(void) {
+    // already running
+    if (sipo_burst_depth > 0) {
+        return true;
+    }
+
+    spi_custom_init(REGISTERS_SPI_DRIVER_ID);
+    return spi_custom_start(SIPO_CS_PIN, false, REGISTERS_SPI_MODE, REGISTERS_SPI_DIV, REGISTERS_SPI_DRIVER_ID);
+}
+
+static void sipo_spi_stop(void) {
+    // will be stopped when burst ends
+    if (sipo_burst_depth > 0) {
+        return;
+    }
+
+    spi_custom_stop(REGISTERS_SPI_DRIVER_ID);
+}
+
 void send_sipo_state(void) {
     if (!sipo_state_changed) {
         sipo_dprintf("[INFO] %s: no changes\n", __func__);
@@ -68,9 +88,7 @@ void send_sipo_state(void) {
 
     sipo_state_changed = false;
 
-    spi_custom_init(REGISTERS_SPI_DRIVER_ID);
-
-    if (!spi_custom_start(SIPO_CS_PIN, false, REGISTERS_SPI_MODE, REGISTERS_SPI_DIV, REGISTERS_SPI_DRIVER_ID)) {
+    if (!sipo_spi_start()) {
         sipo_dprintf("[ERROR] %s: (start SPI)\n", __func__);
         return;
     }
@@ -79,7 +97,27 @@ void send_sipo_state(void) {
     spi_custom_transmit(sipo_pin_state, SIPO_BYTES, REGISTERS_SPI_DRIVER_ID);
     gpio_write_pin_high(SIPO_CS_PIN);
 
-    spi_custom_stop(REGISTERS_SPI_DRIVER_ID);
+    sipo_spi_stop();
 
     print_sipo_status();
 }
+
+bool sipo_burst_start(void) {
+    if (!sipo_spi_start()) {
+        sipo_dprintf("[ERROR] %s: (start SPI)\n", __func__);
+        return false;
+    }
+
+    sipo_burst_depth += 1;
+    return true;
+}
+
+void sipo_burst_end(void) {
+    if (sipo_burst_depth == 0) {
+        sipo_dprintf("[ERROR] %s: not in a burst\n", __func__);
+        return;
+    }
+
+    sipo_burst_depth -= 1;
+    sipo_spi_stop();
+}
@@ -313,6 +313,8 @@ spi_status_t spi_custom_write(uint8_t data, uint8_t n) {
         return SPI_STATUS_ERROR;
     }
 
+    spi_custom_wait(n);
+
     uint8_t rxData;
     spiExchange(drivers[n], 1, &data, &rxData);
 
@@ -325,6 +327,8 @@ spi_status_t spi_custom_read(uint8_t n) {
         return SPI_STATUS_ERROR;
     }
 
+    spi_custom_wait(n);
+
     uint8_t data = 0;
     spiReceive(drivers[n], 1, &data);
 
@@ -337,16 +341,47 @@ spi_status_t spi_custom_transmit(const uint8_t *data, uint16_t length, uint8_t n
         return SPI_STATUS_ERROR;
     }
 
+    spi_custom_wait(n);
+
     spiSend(drivers[n], length, data);
     return SPI_STATUS_SUCCESS;
 }
 
+spi_status_t spi_custom_transmit_async(const uint8_t *data, uint16_t length, uint8_t n) {
+    if (n >= SPI_COUNT) {
+        spi_custom_dprintf("[ERROR] %s: n==%d invalid\n", __func__, n);
+        return SPI_STATUS_ERROR;
+    }
+
+    // only one transfer at a time, wait for the previous one
+    spi_custom_wait(n);
+
+    spiStartSend(drivers[n], length, data);
+    return SPI_STATUS_SUCCESS;
+}
+
+void spi_custom_wait(uint8_t n) {
+    if (n >= SPI_COUNT) {
+        spi_custom_dprintf("[ERROR] %s: n==%d invalid\n", __func__, n);
+        return;
+    }
+
+    // DMA is transferring data in the background, we just spin until done
+    // `state` is written by the ISR, read it as volatile so that it is fetched again on every iteration
+    const volatile spistate_t *state = &drivers[n]->state;
+    while (*state == SPI_ACTIVE) {
+        __DMB();
+    }
+}
+
 spi_status_t spi_custom_receive(uint8_t *data, uint16_t length, uint8_t n) {
     if (n >= SPI_COUNT) {
         spi_custom_dprintf("[ERROR] %s: n==%d invalid\n", __func__, n);
         return SPI_STATUS_ERROR;
     }
 
+    spi_custom_wait(n);
+
     spiReceive(drivers[n], length, data);
     return SPI_STATUS_SUCCESS;
 }
@@ -357,6 +392,8 @@ void spi_custom_stop(uint8_t n) {
         return;
     }
 
+    spi_custom_wait(n);
+
     if (spi_slave_pins[n] != NO_PIN) {
         spiUnselect(drivers[n]);
         spiStop(drivers[n]);
@@ -0,0 +1,50 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/touch.h"
+
+#include <quantum/quantum.h>
+#include <stdlib.h>
+
+static uint16_t distance(touch_report_t a, touch_report_t b) {
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+touch_filter_result_t touch_filter_apply(touch_filter_t *filter, touch_report_t report, touch_report_t *point) {
+    if (!report.pressed) {
+        // not pressed before either, nothing to report
+        if (!filter->pressed) {
+            return TOUCH_FILTER_NONE;
+        }
+
+        filter->pressed = false;
+
+        // receivers already know where the press ended
+        if (distance(filter->last_seen, filter->last_sent) == 0) {
+            return TOUCH_FILTER_RELEASE;
+        }
+
+        *point = filter->last_seen;
+        return TOUCH_FILTER_POINT | TOUCH_FILTER_RELEASE;
+    }
+
+    filter->last_seen = report;
+
+    // on-going press, check whether point is worth sending
+    if (filter->pressed) {
+        if (timer_elapsed32(filter->last_time) < filter->min_interval) {
+            return TOUCH_FILTER_NONE;
+        }
+
+        if (distance(report, filter->last_sent) < filter->min_distance) {
+            return TOUCH_FILTER_NONE;
+        }
+    }
+
+    filter->pressed   = true;
+    filter->last_sent = report;
+    filter->last_time = timer_read32();
+
+    *point = report;
+    return TOUCH_FILTER_POINT;
+}
@@ -7,6 +7,16 @@
 
 #include "elpekenin/logging/backends/split.h"
 
+#if IS_ENABLED(XAP)
+#    include <quantum/xap/xap.h>
+
+#    include "elpekenin/xap.h"
+#endif
+
+#if IS_ENABLED(QUANTUM_PAINTER)
+#    include "elpekenin/qp/assets.h"
+#endif
+
 STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
 #include "elpekenin/logging.h"
 
@@ -15,11 +25,85 @@ STATIC_ASSERT(CM_ENABLED(LOGGING), "Must enable 'elpekenin/logging'");
 #    define SPLIT_LOG_SYNC_DELAY (0)
 #endif
 
+#define XAP_SPLIT_TASK_DELAY (10)
+
 typedef struct {
     bool ok;
     u128 value;
 } build_id_msg_t;
 
+typedef struct {
+    bool    found;
+    uint8_t index;
+} device_index_msg_t;
+
+#if IS_ENABLED(XAP)
+// requests waiting to be packed into a frame, on master
+static struct {
+    xap_split_msg_t msgs[XAP_SPLIT_QUEUE_SIZE];
+    uint8_t         head;
+    uint8_t         count;
+} xap_outbox = {0};
+
+// frame being sent, kept around until slave acknowledges it
+// first frames after boot ask slave to forget the previous one, as `seq` starts over
+static struct {
+    xap_split_frame_t frame;
+    uint8_t           length;
+    uint8_t           retries;
+    bool              pending;
+} xap_tx = {
+    .frame.flags = XAP_SPLIT_FRAME_SYNC,
+};
+
+// requests received by slave, ran outside of the transaction's handler
+static struct {
+    xap_split_msg_t msgs[XAP_SLAVE_QUEUE_SIZE];
+    uint8_t         head;
+    uint8_t         count;
+} xap_queue = {0};
+
+// last frame queued by slave, to detect re-sends whose ack got lost
+static struct {
+    uint8_t seq;
+    bool    valid;
+} xap_rx = {0};
+
+// results on slave, waiting for master to read them
+static xap_split_results_t xap_results = {0};
+
+// outcome of the request being run on slave
+static bool xap_current_ok = true;
+
+// requests sent by master, whose result is yet to be read
+// corrected with the amount slave reports as queued on every read
+static uint8_t xap_pending = 0;
+
+// caller makes sure there's room, results are never dropped
+static void xap_results_push(uint16_t id, bool success) {
+    xap_results.results[xap_results.count].id      = id;
+    xap_results.results[xap_results.count].success = success;
+    xap_results.count += 1;
+}
+
+// walk over the entries on a frame, returns NULL when there are no more (or they are malformed)
+static const xap_split_entry_t* xap_frame_next(const xap_split_frame_t* frame, size_t length, size_t* offset) {
+    const size_t used = length - offsetof(xap_split_frame_t, data);
+
+    if (*offset + sizeof(xap_split_entry_t) > used) {
+        return NULL;
+    }
+
+    const xap_split_entry_t* entry = (const void*)&frame->data[*offset];
+    if (entry->length > XAP_EPSIZE || *offset + sizeof(xap_split_entry_t) + entry->length > used) {
+        return NULL;
+    }
+
+    *offset += sizeof(xap_split_entry_t) + entry->length;
+    return entry;
+}
+#endif
+
 //
 // Slave-side handlers
 //
@@ -33,15 +117,74 @@ static void ee_clear_handler(uint8_t m2s_size, __unused const void* m2s_buffer,
     eeconfig_init();
 }
 
-static void xap_handler(uint8_t m2s_size, const void* m2s_buffer, __unused uint8_t s2m_size, __unused void* s2m_buffer) {
-    if (m2s_size != XAP_EPSIZE) {
+#if IS_ENABLED(XAP)
+static void xap_handler(uint8_t m2s_size, const void* m2s_buffer, uint8_t s2m_size, void* s2m_buffer) {
+    if (m2s_size < offsetof(xap_split_frame_t, data) || m2s_size > sizeof(xap_split_frame_t) || s2m_size != sizeof(xap_split_ack_t)) {
         logging(LOG_ERROR, "%s size", __func__);
         return;
     }
 
-    extern void xap_receive_base(const void* data);
-    xap_receive_base(m2s_buffer);
+    const xap_split_frame_t* frame = m2s_buffer;
+    xap_split_ack_t*         ack   = s2m_buffer;
+
+    ack->seq      = frame->seq;
+    ack->accepted = false;
+
+    // master rebooted, whatever we received before is unrelated to this frame
+    if (frame->flags & XAP_SPLIT_FRAME_SYNC) {
+        xap_rx.valid = false;
+    }
+
+    // master did not get our ack, requests are already queued
+    if (xap_rx.valid && xap_rx.seq == frame->seq) {
+        ack->accepted = true;
+        return;
+    }
+
+    // busy, master will try again later
+    if (frame->count > XAP_SLAVE_QUEUE_SIZE - xap_queue.count) {
+        return;
+    }
+
+    // check the whole frame before queueing any of it
+    size_t offset = 0;
+    for (uint8_t i = 0; i < frame->count; ++i) {
+        if (xap_frame_next(frame, m2s_size, &offset) == NULL) {
+            logging(LOG_ERROR, "%s: malformed frame", __func__);
+            return;
+        }
+    }
+
+    offset = 0;
+    for (uint8_t i = 0; i < frame->count; ++i) {
+        const xap_split_entry_t* entry = xap_frame_next(frame, m2s_size, &offset);
+        xap_split_msg_t*         msg   = &xap_queue.msgs[(xap_queue.head + xap_queue.count) % XAP_SLAVE_QUEUE_SIZE];
+
+        msg->id     = entry->id;
+        msg->length = entry->length;
+        memset(msg->data, 0, sizeof(msg->data));
+        memcpy(msg->data, entry + 1, entry->length);
+
+        xap_queue.count += 1;
+    }
+
+    xap_rx.seq    = frame->seq;
+    xap_rx.valid  = true;
+    ack->accepted = true;
+}
+
+static void xap_results_handler(__unused uint8_t m2s_size, __unused const void* m2s_buffer, uint8_t s2m_size, void* s2m_buffer) {
+    if (s2m_size != sizeof(xap_split_results_t)) {
+        logging(LOG_ERROR, "%s size", __func__);
+        return;
+    }
+
+    xap_results.queued = xap_queue.count;
+
+    memcpy(s2m_buffer, &xap_results, sizeof(xap_split_results_t));
+    xap_results.count = 0;
 }
+#endif
 
 static void build_id_handler(__unused uint8_t m2s_size, __unused const void* m2s_buffer, uint8_t s2m_size, void* s2m_buffer) {
     if (s2m_size != sizeof(build_id_msg_t)) {
@@ -59,6 +202,24 @@ static void build_id_handler(__unused uint8_t m2s_size, __unused const void* m2s
     }
 }
 
+#if IS_ENABLED(QUANTUM_PAINTER)
+static void device_index_handler(uint8_t m2s_size, const void* m2s_buffer, uint8_t s2m_size, void* s2m_buffer) {
+    if (m2s_size == 0 || s2m_size != sizeof(device_index_msg_t)) {
+        return;
+    }
+
+    device_index_msg_t* msg = s2m_buffer;
+
+    // don't trust the terminator to be there
+    char name[RPC_M2S_BUFFER_SIZE] = {0};
+    memcpy(name, m2s_buffer, MIN(m2s_size, sizeof(name) - 1));
+
+    size_t index;
+    msg->found = get_device_index(name, &index) && index <= UINT8_MAX;
+    msg->index = msg->found ? index : 0;
+}
+#endif
+
 //
 // Periodic tasks callbacks
 //
@@ -71,6 +232,147 @@ static uint32_t logging_task_cb(__unused uint32_t trigger_time, __unused void* c
     return user_logging_master_poll();
 }
 
+#if IS_ENABLED(XAP)
+static void xap_slave_run(void) {
+    if (xap_queue.count == 0) {
+        return;
+    }
+
+    // wait for master to read the previous results, instead of losing one
+    if (xap_results.count == XAP_SLAVE_RESULTS_SIZE) {
+        return;
+    }
+
+    const xap_split_msg_t* msg = &xap_queue.msgs[xap_queue.head];
+
+    xap_current_ok = true;
+
+    extern void xap_receive_base(const void* data);
+    xap_receive_base(msg->data);
+
+    xap_results_push(msg->id, xap_current_ok);
+
+    xap_queue.head = (xap_queue.head + 1) % XAP_SLAVE_QUEUE_SIZE;
+    xap_queue.count -= 1;
+}
+
+// pack as many queued requests as possible into a new frame
+static void xap_master_pack(void) {
+    xap_tx.frame.count = 0;
+    xap_tx.length      = offsetof(xap_split_frame_t, data);
+    xap_tx.retries     = 0;
+
+    while (xap_outbox.count > 0) {
+        const xap_split_msg_t* msg  = &xap_outbox.msgs[xap_outbox.head];
+        const size_t           size = sizeof(xap_split_entry_t) + msg->length;
+
+        if (xap_tx.length + size > sizeof(xap_split_frame_t)) {
+            break;
+        }
+
+        const xap_split_entry_t entry = {
+            .id     = msg->id,
+            .length = msg->length,
+        };
+
+        uint8_t* ptr = (uint8_t*)&xap_tx.frame + xap_tx.length;
+        memcpy(ptr, &entry, sizeof(entry));
+        memcpy(ptr + sizeof(entry), msg->data, msg->length);
+
+        xap_tx.length += size;
+        xap_tx.frame.count += 1;
+
+        xap_outbox.head = (xap_outbox.head + 1) % XAP_SPLIT_QUEUE_SIZE;
+        xap_outbox.count -= 1;
+    }
+
+    xap_tx.pending = true;
+}
+
+// give up on a frame, slave may have queued it anyway (only its ack got lost)
+static void xap_master_drop(void) {
+    size_t offset = 0;
+    for (uint8_t i = 0; i < xap_tx.frame.count; ++i) {
+        const xap_split_entry_t* entry = xap_frame_next(&xap_tx.frame, xap_tx.length, &offset);
+        if (entry == NULL) {
+            logging(LOG_ERROR, "%s: malformed frame", __func__);
+            break;
+        }
+
+        xap_completion_lost(entry->id);
+    }
+
+    // ask slave, to find out whether they are running
+    xap_pending = MAX(xap_pending, 1);
+
+    xap_tx.frame.seq += 1;
+    xap_tx.pending = false;
+}
+
+static void xap_master_send(void) {
+    if (!xap_tx.pending) {
+        if (xap_outbox.count == 0) {
+            return;
+        }
+
+        xap_master_pack();
+    }
+
+    xap_split_ack_t ack  = {0};
+    const bool      sent = transaction_rpc_exec(RPC_ID_USER_XAP, xap_tx.length, &xap_tx.frame, sizeof(xap_split_ack_t), &ack) && ack.seq == xap_tx.frame.seq;
+
+    if (sent && ack.accepted) {
+        // do not overflow, reading results corrects it anyway
+        xap_pending = MIN(xap_pending + xap_tx.frame.count, UINT8_MAX);
+
+        xap_tx.frame.seq += 1;
+        xap_tx.frame.flags &= ~XAP_SPLIT_FRAME_SYNC;
+        xap_tx.pending = false;
+        return;
+    }
+
+    // slave's queue is full, not an error
+    if (sent) {
+        return;
+    }
+
+    xap_tx.retries += 1;
+    if (xap_tx.retries == XAP_SPLIT_RETRIES) {
+        logging(LOG_ERROR, "%s: frame %d dropped", __func__, xap_tx.frame.seq);
+        xap_master_drop();
+    }
+}
+
+static void xap_master_poll(void) {
+    if (xap_pending == 0) {
+        return;
+    }
+
+    xap_split_results_t msg = {0};
+    if (!transaction_rpc_recv(RPC_ID_USER_XAP_RESULTS, sizeof(xap_split_results_t), &msg)) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < MIN(msg.count, XAP_SLAVE_RESULTS_SIZE); ++i) {
+        xap_completion_done(msg.results[i].id, msg.results[i].success);
+    }
+
+    // every result was read, what's left is the requests yet to run
+    xap_pending = msg.queued;
+}
+
+static uint32_t xap_task_cb(__unused uint32_t trigger_time, __unused void* cb_arg) {
+    if (is_keyboard_master()) {
+        xap_master_send();
+        xap_master_poll();
+    } else {
+        xap_slave_run();
+    }
+
+    return XAP_SPLIT_TASK_DELAY;
+}
+#endif
+
 //
 // Public API
 //
@@ -83,15 +385,40 @@ void reset_ee_slave(void) {
     transaction_rpc_send(RPC_ID_USER_EEPROM_CLEAR, 0, NULL);
 }
 
-void xap_execute_slave(const void* data) {
-    if (!is_keyboard_master() || !IS_ENABLED(XAP)) {
+#if IS_ENABLED(XAP)
+bool xap_execute_slave(const void* data, uint16_t* id) {
+    if (!is_keyboard_master()) {
+        return false;
+    }
+
+    if (xap_outbox.count == XAP_SPLIT_QUEUE_SIZE) {
+        logging(LOG_WARN, "%s: queue is full", __func__);
+        return false;
+    }
+
+    // only copy the actual message, not the whole buffer
+    const xap_request_header_t* header = data;
+
+    xap_split_msg_t* msg = &xap_outbox.msgs[(xap_outbox.head + xap_outbox.count) % XAP_SPLIT_QUEUE_SIZE];
+
+    msg->id     = xap_completion_new();
+    msg->length = MIN(sizeof(xap_request_header_t) + header->length, XAP_EPSIZE);
+    memcpy(msg->data, data, msg->length);
+
+    xap_outbox.count += 1;
+
+    *id = msg->id;
+    return true;
+}
+
+void xap_slave_result(bool success) {
+    if (is_keyboard_master()) {
         return;
     }
 
-    xap_split_msg_t msg = {0};
-    memcpy(&msg.data, data, XAP_EPSIZE);
-    transaction_rpc_send(RPC_ID_USER_XAP, XAP_EPSIZE, &msg);
+    xap_current_ok &= success;
 }
+#endif
 
 bool get_slave_build_id(u128* build_id) {
     if (!is_keyboard_master()) {
@@ -109,6 +436,25 @@ bool get_slave_build_id(u128* build_id) {
     return true;
 }
 
+#if IS_ENABLED(QUANTUM_PAINTER)
+bool get_slave_device_index(const char* name, size_t* index) {
+    if (!is_keyboard_master()) {
+        return false;
+    }
+
+    device_index_msg_t msg = {0};
+
+    const uint8_t length = strnlen(name, RPC_M2S_BUFFER_SIZE - 1) + 1;
+    const bool    ret    = transaction_rpc_exec(RPC_ID_USER_DEVICE_INDEX, length, name, sizeof(device_index_msg_t), &msg);
+    if (!ret || !msg.found) {
+        return false;
+    }
+
+    *index = msg.index;
+    return true;
+}
+#endif
+
 void transactions_init(void) {
     //
     // rpc handlers
@@ -119,14 +465,23 @@ void transactions_init(void) {
 
     transaction_register_rpc(RPC_ID_USER_EEPROM_CLEAR, ee_clear_handler);
 
-    if (IS_ENABLED(XAP)) {
-        transaction_register_rpc(RPC_ID_USER_XAP, xap_handler);
-    }
+#if IS_ENABLED(XAP)
+    transaction_register_rpc(RPC_ID_USER_XAP, xap_handler);
+    transaction_register_rpc(RPC_ID_USER_XAP_RESULTS, xap_results_handler);
+#endif
 
     transaction_register_rpc(RPC_ID_USER_BUILD_ID, build_id_handler);
 
+#if IS_ENABLED(QUANTUM_PAINTER)
+    transaction_register_rpc(RPC_ID_USER_DEVICE_INDEX, device_index_handler);
+#endif
+
     //
     // periodic tasks
     //
     defer_exec(SPLIT_LOG_SYNC_DELAY, logging_task_cb, NULL);
+
+#if IS_ENABLED(XAP)
+    defer_exec(XAP_SPLIT_TASK_DELAY, xap_task_cb, NULL);
+#endif
 }
@@ -0,0 +1,89 @@
+// Copyright Pablo Martinez (@elpekenin) <elpekenin@elpekenin.dev>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "elpekenin/uart_tx.h"
+
+#include <drivers/uart.h>
+#include <hal.h>
+#include <quantum/quantum.h>
+
+#define UART_TX_TASK_INTERVAL 1
+
+typedef struct {
+    uint8_t  data[UART_TX_BUFFER_SIZE];
+    size_t   tail; // oldest byte
+    size_t   count;
+    uint32_t dropped;
+} uart_tx_ring_t;
+
+static uart_tx_ring_t ring = {0};
+
+static uint32_t       configured_baud = 0; // 0 = not initialized
+static deferred_token token           = INVALID_DEFERRED_TOKEN;
+
+bool uart_tx_init(uint32_t baud) {
+    if (configured_baud != 0) {
+        return baud == configured_baud;
+    }
+
+    uart_init(baud);
+    configured_baud = baud;
+
+    return true;
+}
+
+size_t uart_tx_pending(void) {
+    return ring.count;
+}
+
+uint32_t uart_tx_dropped(void) {
+    return ring.dropped;
+}
+
+// feed the peripheral as much as it takes right now, without waiting for room
+static uint32_t uart_tx_task_cb(__unused uint32_t trigger_time, __unused void *cb_arg) {
+    while (ring.count > 0) {
+        // contiguous chunk, up to the end of the buffer
+        const size_t chunk = MIN(ring.count, UART_TX_BUFFER_SIZE - ring.tail);
+        const size_t sent  = chnWriteTimeout(&UART_DRIVER, &ring.data[ring.tail], chunk, TIME_IMMEDIATE);
+
+        ring.tail = (ring.tail + sent) % UART_TX_BUFFER_SIZE;
+        ring.count -= sent;
+
+        // FIFO is full
+        if (sent < chunk) {
+            return UART_TX_TASK_INTERVAL;
+        }
+    }
+
+    token = INVALID_DEFERRED_TOKEN;
+    return 0;
+}
+
+bool uart_tx_write(const void *data, size_t length) {
+    if (configured_baud == 0) {
+        return false;
+    }
+
+    if (length == 0) {
+        return true;
+    }
+
+    // all or nothing, a partial write would break framing (eg: M5 messages)
+    if (length > UART_TX_BUFFER_SIZE - ring.count) {
+        ring.dropped += length;
+        return false;
+    }
+
+    const uint8_t *ptr = data;
+    for (size_t i = 0; i < length; ++i) {
+        ring.data[(ring.tail + ring.count) % UART_TX_BUFFER_SIZE] = ptr[i];
+        ring.count += 1;
+    }
+
+    if (token == INVALID_DEFERRED_TOKEN) {
+        token = defer_exec(UART_TX_TASK_INTERVAL, uart_tx_task_cb, NULL);
+    }
+
+    return true;
+}
@@ -7,6 +7,14 @@
 
 static uint32_t xap_last_msg = 0;
 
+static struct {
+    struct {
+        uint16_t         id;
+        xap_completion_t status;
+    } entries[XAP_COMPLETIONS_SIZE];
+    uint16_t last_id;
+} completions = {0};
+
 uint32_t xap_last_activity_time(void) {
     return xap_last_msg;
 }
@@ -18,3 +26,48 @@ uint32_t xap_last_activity_elapsed(void) {
 void xap_last_activity_update(void) {
     xap_last_msg = timer_read32();
 }
+
+//
+// deferred results
+//
+
+uint16_t xap_completion_new(void) {
+    completions.last_id += 1;
+
+    // 0 is used to flag empty entries
+    if (completions.last_id == 0) {
+        completions.last_id = 1;
+    }
+
+    const uint16_t id = completions.last_id;
+
+    // oldest entry gets overwritten
+    completions.entries[id % XAP_COMPLETIONS_SIZE].id     = id;
+    completions.entries[id % XAP_COMPLETIONS_SIZE].status = XAP_COMPLETION_PENDING;
+
+    return id;
+}
+
+void xap_completion_done(uint16_t id, bool success) {
+    if (completions.entries[id % XAP_COMPLETIONS_SIZE].id != id) {
+        return;
+    }
+
+    completions.entries[id % XAP_COMPLETIONS_SIZE].status = success ? XAP_COMPLETION_SUCCESS : XAP_COMPLETION_FAILURE;
+}
+
+void xap_completion_lost(uint16_t id) {
+    if (completions.entries[id % XAP_COMPLETIONS_SIZE].id != id) {
+        return;
+    }
+
+    completions.entries[id % XAP_COMPLETIONS_SIZE].status = XAP_COMPLETION_LOST;
+}
+
+xap_completion_t xap_completion_get(uint16_t id) {
+    if (id == 0 || completions.entries[id % XAP_COMPLETIONS_SIZE].id != id) {
+        return XAP_COMPLETION_UNKNOWN;
+    }
+
+    return completions.entries[id % XAP_COMPLETIONS_SIZE].status;
+}